@@ -0,0 +1,160 @@
+﻿#include "Data.h"
+#include "Stepwise_engine.h"
+#include "Incumbent.h"
+#include "Float_mode.h"
+#include<algorithm>
+#include<atomic>
+#include<iostream>
+#include<fstream>
+#include<thread>
+#include<vector>
+#include<chrono>
+#include <cmath>
+
+//Bidirectional stepwise method: the forward engine adds the jobs 0, 1, ... and the backward engine the jobs n-1, n-2, ...
+//on two threads until they meet at job k. Every job is claimed from a shared counter by the engine that is ready first,
+//so k balances the work of both sides. The forward hull then holds the prefixes S of jobs 0..k-1 that are optimal for
+//some revenue R of the selected jobs from k on, and the backward hull the suffixes T of jobs k..n-1 that are optimal for
+//some probability P of the selected jobs before k. The optimal selection is the pair maximizing the forward hull at
+//R = R(T) (the slope of T) minus C(T) (the intercept of T).
+int main(int argc, char* argv[])
+{
+	if (argc != 2)
+	{
+		std::cout << "Usage: " << argv[0] << " < filename > " << std::endl;
+		return 0;
+	}
+
+	Data::ReadData(argv[1]);
+	Data::SortData();
+	Data::Print_Data();
+	Flush_denormals();
+
+	//Start timer
+	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+
+	//Initialize values, the bounds hold for the optimal selection so they are valid for both halves
+	std::vector<double> upper_R = Stepwise_bounds::Upper_R();
+	std::vector<double> lower_P = Stepwise_bounds::Lower_P();
+	std::vector<double> gain = Stepwise_bounds::Prefix_gain();
+	std::vector<bool> incumbent_set;
+	double incumbent = Stepwise_incumbent::Solve(incumbent_set);
+	double target = Stepwise_bounds::Target(incumbent);
+	Forward_engine forward(upper_R, target);
+	Backward_engine backward(lower_P, gain, target);
+
+	//Algorithm
+	std::atomic<int> claimed(0);
+	int k = 0;
+	int first_backward = Data::n;
+	std::thread backward_thread([&]()
+		{
+			Flush_denormals();
+			while (claimed.fetch_add(1) < Data::n)
+			{
+				backward.Step(--first_backward);
+			}
+		});
+	while (claimed.fetch_add(1) < Data::n)
+	{
+		forward.Step(k++);
+	}
+	backward_thread.join();
+
+	//Combine: the backward lines are sorted by increasing R(T), so one walk over the forward hull finds the forward line optimal at every R(T)
+	double best_profit = std::numeric_limits<double>::lowest();
+	int best_forward = 0;
+	int best_backward = 0;
+	size_t s = 0;
+	for (size_t t = 0; t < backward.hull.size(); t++)
+	{
+		double R = backward.hull[t].slope;
+		while (forward.hull[s].limit < R)
+		{
+			s++;
+		}
+		double profit = forward.hull[s].intercept + forward.hull[s].slope * R + backward.hull[t].intercept;
+		if (profit > best_profit)
+		{
+			best_profit = profit;
+			best_forward = (int)s;
+			best_backward = (int)t;
+		}
+	}
+	std::vector<bool> solution = forward.tree.Materialize(forward.hull[best_forward].set, Data::n);
+	std::vector<bool> suffix = backward.tree.Materialize(backward.hull[best_backward].set, Data::n);
+	for (int i = k; i < Data::n; i++)
+	{
+		solution[i] = suffix[i];
+	}
+
+	//End timer
+	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+
+	std::cout << "\nOptimal set:\n" << std::endl;
+	std::cout << "[";
+	for (int i = 0; i < Data::n - 1; i++)
+	{
+		std::cout << solution[i] << ",";
+	}
+	std::cout << solution[Data::n - 1] << "]\t with objective value: " << best_profit << std::endl;
+	std::cout << "Jobs 0.." << k - 1 << " forward (" << forward.hull.size() << " lines), jobs " << k << ".." << Data::n - 1 << " backward (" << backward.hull.size() << " lines)" << std::endl;
+	std::cout << "Number of sets considered: " << forward.nr_sets + backward.nr_sets << " out of " << (std::pow(2, Data::n)) << std::endl;
+	std::cout << std::endl;
+
+	//Write results to file
+	std::string inputFilename = argv[1];
+	std::string baseFilename;
+	std::string outputFilename;
+
+	// Check if it ends with ".dat"
+	if (inputFilename.size() >= 4 && inputFilename.substr(inputFilename.size() - 4) == ".dat") {
+		// Strip .dat extension
+		baseFilename = inputFilename.substr(0, inputFilename.size() - 4);
+	}
+	else {
+		std::cerr << "Input file does not have a .dat extension." << std::endl;
+		return 1;
+	}
+
+	// Find last slash
+	size_t lastSlash = baseFilename.find_last_of("/");
+
+	if (lastSlash != std::string::npos) {
+		// There is a directory in the path
+		std::string folder = baseFilename.substr(0, lastSlash); 
+		std::string filenameOnly = baseFilename.substr(lastSlash + 1);
+
+		// Go one level up from folder and then into "output/"
+		outputFilename = folder + "/output/" + filenameOnly + ".out";
+	}
+	else {
+		// No slashes, just replace .dat with .out
+		outputFilename = baseFilename + ".out";
+	}
+
+
+	// Open output file for writing
+	std::ofstream outFile(outputFilename);
+	if (!outFile) {
+		std::cerr << "Could not open file for writing: " << outputFilename << std::endl;
+		return 1;
+	}
+
+	// Write to output file
+	outFile << best_profit << std::endl;
+	outFile << std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1).count() << std::endl;
+	outFile << Data::n << std::endl;
+	outFile << forward.nr_sets + backward.nr_sets << std::endl;
+	for (int i = 0; i < Data::n; i++)
+	{
+		outFile << solution[i] << "\t" << Data::r[i] << "\t" << Data::c[i] << "\t" << Data::p[i] << std::endl;
+	}
+
+	//Write the counters of every step next to the output file
+	std::string traceFilename = Trace_filename(outputFilename);
+	if (!Write_trace(traceFilename, { &forward.trace, &backward.trace }, "FB")) {
+		std::cerr << "Could not write trace: " << traceFilename << std::endl;
+		return 1;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,191 @@
+#pragma once
+#include<algorithm>
+#include<cstdint>
+#include<cstring>
+#include<fstream>
+#include<string>
+#include<vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<unistd.h>
+#endif
+
+//Budget frontier file of the DP: the best expected revenue for every budget 0..width[0] and the take/skip decisions
+//needed to reconstruct the best selection for any spending cap, so budget-capped queries need no new DP.
+//Layout (native byte order): magic "UJSSPFR1", n, width[0], then n probabilities (double), n costs, n revenues and
+//n row widths (int32), then for every budget the expected revenue (double) and the best budget up to it (int32),
+//then the decision rows of jobs 0..n-1, row n holding width[n] / 64 + 1 words with one bit per budget.
+const char frontier_magic[8] = { 'U', 'J', 'S', 'S', 'P', 'F', 'R', '1' };
+
+template<typename T>
+void Write_values(std::ofstream& out, const T* values, size_t count)
+{
+	out.write((const char*)values, (std::streamsize)(count * sizeof(T)));
+}
+
+template<typename T>
+void Read_values(std::ifstream& in, T* values, size_t count)
+{
+	in.read((char*)values, (std::streamsize)(count * sizeof(T)));
+}
+
+//Write the frontier of the jobs with probabilities p, costs c and revenues r; revenue[b] is the best expected revenue with budget b and decisions[n]
+//points to the decision row of job n
+inline bool Write_frontier(const std::string& filename, const std::vector<double>& p, const std::vector<int>& c, const std::vector<int>& r,
+	const std::vector<int>& width, const std::vector<double>& revenue, const std::vector<const uint64_t*>& decisions)
+{
+	std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+	if (!out)
+	{
+		return false;
+	}
+	int32_t n = (int32_t)p.size();
+	int32_t max_width = width[0];
+	out.write(frontier_magic, sizeof(frontier_magic));
+	Write_values(out, &n, 1);
+	Write_values(out, &max_width, 1);
+	Write_values(out, p.data(), n);
+	std::vector<int32_t> values(c.begin(), c.end());
+	Write_values(out, values.data(), n);
+	values.assign(r.begin(), r.end());
+	Write_values(out, values.data(), n);
+	values.assign(width.begin(), width.begin() + n);
+	Write_values(out, values.data(), n);
+
+	//Best budget up to b: the budget with the largest revenue minus budget, ties go to the smallest budget
+	Write_values(out, revenue.data(), max_width + 1);
+	std::vector<int32_t> best_budget(max_width + 1);
+	for (int b = 0; b <= max_width; b++)
+	{
+		best_budget[b] = b > 0 && revenue[best_budget[b - 1]] - best_budget[b - 1] >= revenue[b] - b ? best_budget[b - 1] : b;
+	}
+	Write_values(out, best_budget.data(), max_width + 1);
+
+	for (int i = 0; i < n; i++)
+	{
+		Write_values(out, decisions[i], width[i] / 64 + 1);
+	}
+	return out.good();
+}
+
+//Frontier file opened for queries: the small arrays are read into memory, the decision rows are memory-mapped where possible
+class Frontier_file
+{
+public:
+	int n = 0;
+	int max_width = 0;
+	std::vector<double> p;
+	std::vector<int32_t> c;
+	std::vector<int32_t> r;
+	std::vector<int32_t> width;
+	std::vector<double> revenue;
+	std::vector<int32_t> best_budget;
+
+	~Frontier_file()
+	{
+#if defined(__unix__) || defined(__APPLE__)
+		if (mapped != nullptr)
+		{
+			munmap(mapped, mapped_bytes);
+		}
+#endif
+	}
+
+	bool Open(const std::string& filename)
+	{
+		std::ifstream in(filename, std::ios::binary);
+		char magic[8];
+		in.read(magic, sizeof(magic));
+		if (!in || std::memcmp(magic, frontier_magic, sizeof(magic)) != 0)
+		{
+			return false;
+		}
+		Read_values(in, &n, 1);
+		Read_values(in, &max_width, 1);
+		p.resize(n);
+		c.resize(n);
+		r.resize(n);
+		width.resize(n);
+		revenue.resize((size_t)max_width + 1);
+		best_budget.resize((size_t)max_width + 1);
+		Read_values(in, p.data(), n);
+		Read_values(in, c.data(), n);
+		Read_values(in, r.data(), n);
+		Read_values(in, width.data(), n);
+		Read_values(in, revenue.data(), revenue.size());
+		Read_values(in, best_budget.data(), best_budget.size());
+		if (!in)
+		{
+			return false;
+		}
+
+		size_t words = 0;
+		for (int i = 0; i < n; i++)
+		{
+			row_offsets.push_back(words);
+			words += width[i] / 64 + 1;
+		}
+		size_t begin = (size_t)in.tellg();
+#if defined(__unix__) || defined(__APPLE__)
+		int fd = open(filename.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			return false;
+		}
+		mapped_bytes = begin + words * sizeof(uint64_t);
+		void* map = mmap(nullptr, mapped_bytes, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if (map == MAP_FAILED)
+		{
+			mapped = nullptr;
+			return false;
+		}
+		mapped = map;
+		decision_bytes = (const char*)map + begin;
+#else
+		decision_words.resize(words);
+		Read_values(in, decision_words.data(), words);
+		decision_bytes = (const char*)decision_words.data();
+		if (!in)
+		{
+			return false;
+		}
+#endif
+		return true;
+	}
+
+	//Best selection whose cost does not exceed cap: returns its cost and fills in the selected jobs
+	int Query(long long cap, std::vector<int>& selected) const
+	{
+		selected.clear();
+		if (cap < 0)
+		{
+			return 0;
+		}
+		//The optimal budget of the DP never exceeds width[0], so larger caps have the same answer
+		int budget = best_budget[(size_t)std::min(cap, (long long)max_width)];
+		int cost = 0;
+		for (int i = 0; i < n; i++)
+		{
+			int b = std::min(budget, width[i]);
+			uint64_t word;
+			std::memcpy(&word, decision_bytes + (row_offsets[i] + b / 64) * sizeof(uint64_t), sizeof(word));
+			if ((word >> (b % 64)) & 1)
+			{
+				selected.push_back(i);
+				budget -= c[i];
+				cost += c[i];
+			}
+		}
+		return cost;
+	}
+
+private:
+	std::vector<size_t> row_offsets; //First word of every decision row
+	const char* decision_bytes = nullptr;
+	void* mapped = nullptr;
+	size_t mapped_bytes = 0;
+	std::vector<uint64_t> decision_words;
+};
@@ -0,0 +1,190 @@
+#pragma once
+#include<algorithm>
+#include<cstdint>
+#include<cstdio>
+#include<cstring>
+#include<fstream>
+#include<string>
+#include<vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define DECISION_SPILL_MMAP true
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<unistd.h>
+#else
+#define DECISION_SPILL_MMAP false
+#endif
+
+//Spill file for the take/skip decisions of the DP, for when the decisions of all jobs do not fit in memory.
+//Rows are appended one by one and read back in reverse order (newest first), which is the order of backtracking.
+//Every row is stored as the XOR with the previously appended row, since the decisions of adjacent jobs differ in few budgets,
+//and the XOR is run-length encoded as (number of zero words, number of literal words, literal words) runs.
+//Only the last appended row is kept in memory: reading back starts from it and undoes the XORs one row at a time.
+//The file is memory-mapped for reading where possible and removed when the spill is destroyed.
+class Decision_spill
+{
+public:
+	Decision_spill(const std::string& spill_filename, int words_per_row)
+		: filename(spill_filename), nr_words(words_per_row), last(words_per_row, 0), delta(words_per_row)
+	{
+		out.open(filename, std::ios::binary | std::ios::trunc);
+	}
+
+	~Decision_spill()
+	{
+		Unmap();
+		if (out.is_open())
+		{
+			out.close();
+		}
+		std::remove(filename.c_str());
+	}
+
+	bool Is_open() const
+	{
+		return out.is_open();
+	}
+
+	//Append one row of nr_words words
+	void Append(const uint64_t* row)
+	{
+		offsets.push_back(bytes_written);
+		for (int w = 0; w < nr_words; w++)
+		{
+			delta[w] = row[w] ^ last[w];
+			last[w] = row[w];
+		}
+		int w = 0;
+		while (w < nr_words)
+		{
+			uint32_t zeros = 0;
+			while (w < nr_words && delta[w] == 0)
+			{
+				zeros++;
+				w++;
+			}
+			int begin = w;
+			while (w < nr_words && delta[w] != 0)
+			{
+				w++;
+			}
+			uint32_t literals = (uint32_t)(w - begin);
+			out.write((const char*)&zeros, sizeof(zeros));
+			out.write((const char*)&literals, sizeof(literals));
+			out.write((const char*)&delta[begin], (std::streamsize)literals * sizeof(uint64_t));
+			bytes_written += sizeof(zeros) + sizeof(literals) + literals * sizeof(uint64_t);
+		}
+	}
+
+	//Stop appending and prepare to read the rows back, newest first
+	bool Start_reading()
+	{
+		if (!out.good())
+		{
+			return false;
+		}
+		out.close();
+		next = (int)offsets.size() - 1;
+		current = last;
+		if (bytes_written == 0)
+		{
+			return true;
+		}
+#if DECISION_SPILL_MMAP
+		int fd = open(filename.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			return false;
+		}
+		void* map = mmap(nullptr, bytes_written, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (map == MAP_FAILED)
+		{
+			return false;
+		}
+		mapped = (const char*)map;
+		return true;
+#else
+		in.open(filename, std::ios::binary);
+		return in.is_open();
+#endif
+	}
+
+	//Copy the next row, starting with the last one appended, into row
+	void Read_next(uint64_t* row)
+	{
+		std::copy(current.begin(), current.end(), row);
+
+		//Undo the XOR of this row to get the row appended before it
+		size_t end = next + 1 < (int)offsets.size() ? offsets[next + 1] : bytes_written;
+		const char* data = Load(offsets[next], end);
+		int w = 0;
+		while (w < nr_words)
+		{
+			uint32_t zeros;
+			uint32_t literals;
+			std::memcpy(&zeros, data, sizeof(zeros));
+			std::memcpy(&literals, data + sizeof(zeros), sizeof(literals));
+			data += sizeof(zeros) + sizeof(literals);
+			w += zeros;
+			for (uint32_t i = 0; i < literals; i++, w++)
+			{
+				uint64_t word;
+				std::memcpy(&word, data, sizeof(word));
+				data += sizeof(word);
+				current[w] ^= word;
+			}
+		}
+		next--;
+	}
+
+	//Size of the spill file and of the rows it holds, in bytes
+	size_t Bytes_written() const
+	{
+		return bytes_written;
+	}
+
+	size_t Raw_bytes() const
+	{
+		return offsets.size() * nr_words * sizeof(uint64_t);
+	}
+
+private:
+	std::string filename;
+	int nr_words;
+	std::ofstream out;
+	size_t bytes_written = 0;
+	std::vector<size_t> offsets; //Position of every row in the file
+	std::vector<uint64_t> last; //Last row appended
+	std::vector<uint64_t> delta; //XOR of the row being appended with the last one
+	std::vector<uint64_t> current; //Row that Read_next returns
+	int next = -1; //Row whose XOR is undone by the next Read_next
+	const char* mapped = nullptr;
+	std::ifstream in;
+	std::vector<char> buffer;
+
+	//Bytes begin..end of the file
+	const char* Load(size_t begin, size_t end)
+	{
+		if (mapped != nullptr)
+		{
+			return mapped + begin;
+		}
+		buffer.resize(end - begin);
+		in.seekg((std::streamoff)begin);
+		in.read(buffer.data(), (std::streamsize)(end - begin));
+		return buffer.data();
+	}
+
+	void Unmap()
+	{
+#if DECISION_SPILL_MMAP
+		if (mapped != nullptr)
+		{
+			munmap((void*)mapped, bytes_written);
+			mapped = nullptr;
+		}
+#endif
+	}
+};
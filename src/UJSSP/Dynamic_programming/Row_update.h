@@ -0,0 +1,616 @@
+#pragma once
+#include<algorithm>
+#include<cmath>
+#include<cstdint>
+#include<string>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define ROW_UPDATE_X86 true
+#include<immintrin.h>
+#if defined(_MSC_VER)
+#include<intrin.h>
+#endif
+#else
+#define ROW_UPDATE_X86 false
+#endif
+
+#if ROW_UPDATE_X86 && defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define TARGET_AVX2
+#define TARGET_AVX512
+#endif
+
+#ifndef FIXED_POINT_SCALE
+#define FIXED_POINT_SCALE 1048576.0 //Fixed-point revenues are stored in units of 1 / FIXED_POINT_SCALE
+#endif
+
+//Revenues in 64-bit fixed-point, see FIXED_POINT_SCALE
+typedef int64_t Fixed_point;
+
+//Numeric policies of the revenue rows: how a job is applied to a revenue and how revenues are converted to double
+//Every policy includes a job only if that is strictly better, so ties always go to skipping the job
+template<typename T>
+struct Revenue_policy;
+
+template<>
+struct Revenue_policy<double>
+{
+	double p;
+	double r;
+	Revenue_policy(double prob, double revenue) : p(prob), r(revenue) {}
+	double Include(double old) const { return p * (r + old); }
+	static double To_double(double value) { return value; }
+	static const char* Name() { return "double"; }
+	//Bound on the error of a revenue after n jobs, relative to the revenue itself
+	static double Error(int n, double revenue) { return 2.0 * n * revenue * 1.2e-16; }
+};
+
+template<>
+struct Revenue_policy<float>
+{
+	float p;
+	float r;
+	Revenue_policy(double prob, double revenue) : p((float)prob), r((float)revenue) {}
+	float Include(float old) const { return p * (r + old); }
+	static double To_double(float value) { return value; }
+	static const char* Name() { return "float"; }
+	static double Error(int n, double revenue) { return 3.0 * n * revenue * 6.0e-8; }
+};
+
+//Fixed-point revenues are multiplied by the probability in 0.32 fixed-point: value * p >> 32 is computed as
+//(value >> 32) * p + ((value & 0xffffffff) * p >> 32), which only needs 32x32-bit products, also in the vector kernels
+template<>
+struct Revenue_policy<Fixed_point>
+{
+	uint64_t p;
+	Fixed_point r;
+	Revenue_policy(double prob, double revenue) : p(std::min((uint64_t)std::llround(prob * 4294967296.0), (uint64_t)0xffffffff)), r((Fixed_point)std::llround(revenue * FIXED_POINT_SCALE)) {}
+	Fixed_point Include(Fixed_point old) const
+	{
+		uint64_t value = (uint64_t)(r + old);
+		return (Fixed_point)((value >> 32) * p + (((value & 0xffffffff) * p) >> 32));
+	}
+	static double To_double(Fixed_point value) { return value / FIXED_POINT_SCALE; }
+	static const char* Name() { return "fixed-point"; }
+	static double Error(int n, double revenue) { return n * (2.0 / FIXED_POINT_SCALE + revenue * 2.4e-10); }
+};
+
+//Row update kernels of the dynamic programming algorithm
+//All kernels compute, for i in [0, count): new_row[i] = max(old_row[i], p * (r + old_row[i - cost])),
+//where including the job is only possible from i >= first, and set bit i of bits if including is strictly better.
+//Rows are addressed relative to the first budget of the range, which has to be a multiple of 64 so bits start at a word boundary.
+//If bits is nullptr, no decisions are stored.
+template<typename T>
+using Row_kernel = void (*)(const T* old_row, T* new_row, uint64_t* bits, int first, int count, int cost, double p, double r);
+
+//Scalar version of one 64-budget word, used by every kernel for partial words
+template<typename T>
+inline uint64_t Update_word_scalar(const T* old_row, T* new_row, int begin, int end, int first, int cost, const Revenue_policy<T>& job)
+{
+	uint64_t word = 0;
+	for (int i = begin; i < end; i++)
+	{
+		new_row[i] = old_row[i];
+		if (i >= first)
+		{
+			T including = job.Include(old_row[i - cost]);
+			if (including > new_row[i])
+			{
+				new_row[i] = including;
+				word |= (uint64_t)1 << (i - begin);
+			}
+		}
+	}
+	return word;
+}
+
+template<typename T>
+inline void Update_row_scalar(const T* old_row, T* new_row, uint64_t* bits, int first, int count, int cost, double p, double r)
+{
+	Revenue_policy<T> job(p, r);
+	for (int begin = 0; begin < count; begin += 64)
+	{
+		int end = std::min(begin + 64, count);
+		uint64_t word = Update_word_scalar(old_row, new_row, begin, end, first, cost, job);
+		if (bits != nullptr)
+		{
+			bits[begin / 64] = word;
+		}
+	}
+}
+
+#if ROW_UPDATE_X86
+//Vector kernels: Update_full_word computes one word of 64 budgets that all lie in [first, count)
+//The word loop is shared by all instruction sets
+template<typename T, typename Word_function>
+inline void Update_row_words(const T* old_row, T* new_row, uint64_t* bits, int first, int count, int cost, const Revenue_policy<T>& job, Word_function update_full_word)
+{
+	for (int begin = 0; begin < count; begin += 64)
+	{
+		uint64_t word;
+		if (begin >= first && begin + 64 <= count)
+		{
+			word = update_full_word(old_row + begin, old_row + begin - cost, new_row + begin);
+		}
+		else
+		{
+			word = Update_word_scalar(old_row, new_row, begin, std::min(begin + 64, count), first, cost, job);
+		}
+		if (bits != nullptr)
+		{
+			bits[begin / 64] = word;
+		}
+	}
+}
+
+inline void Update_row_sse2_double(const double* old_row, double* new_row, uint64_t* bits, int first, int count, int cost, double p, double r)
+{
+	Revenue_policy<double> job(p, r);
+	__m128d vp = _mm_set1_pd(job.p);
+	__m128d vr = _mm_set1_pd(job.r);
+	Update_row_words(old_row, new_row, bits, first, count, cost, job, [&](const double* skip, const double* shifted, double* out)
+		{
+			uint64_t word = 0;
+			for (int k = 0; k < 64; k += 2)
+			{
+				__m128d skipping = _mm_loadu_pd(skip + k);
+				__m128d including = _mm_mul_pd(vp, _mm_add_pd(vr, _mm_loadu_pd(shifted + k)));
+				_mm_storeu_pd(out + k, _mm_max_pd(skipping, including));
+				word |= (uint64_t)_mm_movemask_pd(_mm_cmpgt_pd(including, skipping)) << k;
+			}
+			return word;
+		});
+}
+
+inline void Update_row_sse2_float(const float* old_row, float* new_row, uint64_t* bits, int first, int count, int cost, double p, double r)
+{
+	Revenue_policy<float> job(p, r);
+	__m128 vp = _mm_set1_ps(job.p);
+	__m128 vr = _mm_set1_ps(job.r);
+	Update_row_words(old_row, new_row, bits, first, count, cost, job, [&](const float* skip, const float* shifted, float* out)
+		{
+			uint64_t word = 0;
+			for (int k = 0; k < 64; k += 4)
+			{
+				__m128 skipping = _mm_loadu_ps(skip + k);
+				__m128 including = _mm_mul_ps(vp, _mm_add_ps(vr, _mm_loadu_ps(shifted + k)));
+				_mm_storeu_ps(out + k, _mm_max_ps(skipping, including));
+				word |= (uint64_t)_mm_movemask_ps(_mm_cmpgt_ps(including, skipping)) << k;
+			}
+			return word;
+		});
+}
+
+TARGET_AVX2 inline void Update_row_avx2_double(const double* old_row, double* new_row, uint64_t* bits, int first, int count, int cost, double p, double r)
+{
+	Revenue_policy<double> job(p, r);
+	__m256d vp = _mm256_set1_pd(job.p);
+	__m256d vr = _mm256_set1_pd(job.r);
+	Update_row_words(old_row, new_row, bits, first, count, cost, job, [&](const double* skip, const double* shifted, double* out) TARGET_AVX2
+		{
+			uint64_t word = 0;
+			for (int k = 0; k < 64; k += 4)
+			{
+				__m256d skipping = _mm256_loadu_pd(skip + k);
+				__m256d including = _mm256_mul_pd(vp, _mm256_add_pd(vr, _mm256_loadu_pd(shifted + k)));
+				_mm256_storeu_pd(out + k, _mm256_max_pd(skipping, including));
+				word |= (uint64_t)_mm256_movemask_pd(_mm256_cmp_pd(including, skipping, _CMP_GT_OQ)) << k;
+			}
+			return word;
+		});
+}
+
+TARGET_AVX2 inline void Update_row_avx2_float(const float* old_row, float* new_row, uint64_t* bits, int first, int count, int cost, double p, double r)
+{
+	Revenue_policy<float> job(p, r);
+	__m256 vp = _mm256_set1_ps(job.p);
+	__m256 vr = _mm256_set1_ps(job.r);
+	Update_row_words(old_row, new_row, bits, first, count, cost, job, [&](const float* skip, const float* shifted, float* out) TARGET_AVX2
+		{
+			uint64_t word = 0;
+			for (int k = 0; k < 64; k += 8)
+			{
+				__m256 skipping = _mm256_loadu_ps(skip + k);
+				__m256 including = _mm256_mul_ps(vp, _mm256_add_ps(vr, _mm256_loadu_ps(shifted + k)));
+				_mm256_storeu_ps(out + k, _mm256_max_ps(skipping, including));
+				word |= (uint64_t)_mm256_movemask_ps(_mm256_cmp_ps(including, skipping, _CMP_GT_OQ)) << k;
+			}
+			return word;
+		});
+}
+
+TARGET_AVX2 inline void Update_row_avx2_fixed(const Fixed_point* old_row, Fixed_point* new_row, uint64_t* bits, int first, int count, int cost, double p, double r)
+{
+	Revenue_policy<Fixed_point> job(p, r);
+	__m256i vp = _mm256_set1_epi64x((long long)job.p);
+	__m256i vr = _mm256_set1_epi64x(job.r);
+	Update_row_words(old_row, new_row, bits, first, count, cost, job, [&](const Fixed_point* skip, const Fixed_point* shifted, Fixed_point* out) TARGET_AVX2
+		{
+			uint64_t word = 0;
+			for (int k = 0; k < 64; k += 4)
+			{
+				__m256i skipping = _mm256_loadu_si256((const __m256i*)(skip + k));
+				__m256i value = _mm256_add_epi64(vr, _mm256_loadu_si256((const __m256i*)(shifted + k)));
+				__m256i including = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(value, 32), vp), _mm256_srli_epi64(_mm256_mul_epu32(value, vp), 32));
+				__m256i take = _mm256_cmpgt_epi64(including, skipping);
+				_mm256_storeu_si256((__m256i*)(out + k), _mm256_blendv_epi8(skipping, including, take));
+				word |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(take)) << k;
+			}
+			return word;
+		});
+}
+
+TARGET_AVX512 inline void Update_row_avx512_double(const double* old_row, double* new_row, uint64_t* bits, int first, int count, int cost, double p, double r)
+{
+	Revenue_policy<double> job(p, r);
+	__m512d vp = _mm512_set1_pd(job.p);
+	__m512d vr = _mm512_set1_pd(job.r);
+	Update_row_words(old_row, new_row, bits, first, count, cost, job, [&](const double* skip, const double* shifted, double* out) TARGET_AVX512
+		{
+			uint64_t word = 0;
+			for (int k = 0; k < 64; k += 8)
+			{
+				__m512d skipping = _mm512_loadu_pd(skip + k);
+				__m512d including = _mm512_mul_pd(vp, _mm512_add_pd(vr, _mm512_loadu_pd(shifted + k)));
+				__mmask8 take = _mm512_cmp_pd_mask(including, skipping, _CMP_GT_OQ);
+				_mm512_storeu_pd(out + k, _mm512_mask_blend_pd(take, skipping, including));
+				word |= (uint64_t)take << k;
+			}
+			return word;
+		});
+}
+
+TARGET_AVX512 inline void Update_row_avx512_float(const float* old_row, float* new_row, uint64_t* bits, int first, int count, int cost, double p, double r)
+{
+	Revenue_policy<float> job(p, r);
+	__m512 vp = _mm512_set1_ps(job.p);
+	__m512 vr = _mm512_set1_ps(job.r);
+	Update_row_words(old_row, new_row, bits, first, count, cost, job, [&](const float* skip, const float* shifted, float* out) TARGET_AVX512
+		{
+			uint64_t word = 0;
+			for (int k = 0; k < 64; k += 16)
+			{
+				__m512 skipping = _mm512_loadu_ps(skip + k);
+				__m512 including = _mm512_mul_ps(vp, _mm512_add_ps(vr, _mm512_loadu_ps(shifted + k)));
+				__mmask16 take = _mm512_cmp_ps_mask(including, skipping, _CMP_GT_OQ);
+				_mm512_storeu_ps(out + k, _mm512_mask_blend_ps(take, skipping, including));
+				word |= (uint64_t)take << k;
+			}
+			return word;
+		});
+}
+
+TARGET_AVX512 inline void Update_row_avx512_fixed(const Fixed_point* old_row, Fixed_point* new_row, uint64_t* bits, int first, int count, int cost, double p, double r)
+{
+	Revenue_policy<Fixed_point> job(p, r);
+	__m512i vp = _mm512_set1_epi64((long long)job.p);
+	__m512i vr = _mm512_set1_epi64(job.r);
+	Update_row_words(old_row, new_row, bits, first, count, cost, job, [&](const Fixed_point* skip, const Fixed_point* shifted, Fixed_point* out) TARGET_AVX512
+		{
+			uint64_t word = 0;
+			for (int k = 0; k < 64; k += 8)
+			{
+				__m512i skipping = _mm512_loadu_si512(skip + k);
+				__m512i value = _mm512_add_epi64(vr, _mm512_loadu_si512(shifted + k));
+				__m512i including = _mm512_add_epi64(_mm512_maskz_mul_epu32(0xff, _mm512_maskz_srli_epi64(0xff, value, 32), vp), _mm512_maskz_srli_epi64(0xff, _mm512_maskz_mul_epu32(0xff, value, vp), 32));
+				__mmask8 take = _mm512_cmpgt_epi64_mask(including, skipping);
+				_mm512_storeu_si512(out + k, _mm512_mask_blend_epi64(take, skipping, including));
+				word |= (uint64_t)take << k;
+			}
+			return word;
+		});
+}
+#endif
+
+//Check which instruction sets are supported by the processor we are running on
+inline bool Cpu_supports(const std::string& instruction_set)
+{
+#if ROW_UPDATE_X86 && defined(__GNUC__)
+	__builtin_cpu_init();
+	if (instruction_set == "sse2") return __builtin_cpu_supports("sse2");
+	if (instruction_set == "avx2") return __builtin_cpu_supports("avx2");
+	if (instruction_set == "avx512") return __builtin_cpu_supports("avx512f");
+#elif ROW_UPDATE_X86 && defined(_MSC_VER)
+	int info[4];
+	__cpuidex(info, 1, 0);
+	bool os_avx = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+	bool os_avx512 = os_avx && (_xgetbv(0) & 0xe6) == 0xe6;
+	__cpuidex(info, 7, 0);
+	if (instruction_set == "sse2") return true;
+	if (instruction_set == "avx2") return os_avx && (info[1] & (1 << 5));
+	if (instruction_set == "avx512") return os_avx512 && (info[1] & (1 << 16));
+#endif
+	return instruction_set == "scalar";
+}
+
+//Vector kernels of every numeric policy, nullptr if there is none for an instruction set
+template<typename T>
+struct Vector_kernels;
+
+template<>
+struct Vector_kernels<double>
+{
+#if ROW_UPDATE_X86
+	static Row_kernel<double> Get(const std::string& name)
+	{
+		if (name == "sse2") return Update_row_sse2_double;
+		if (name == "avx2") return Update_row_avx2_double;
+		if (name == "avx512") return Update_row_avx512_double;
+		return nullptr;
+	}
+#else
+	static Row_kernel<double> Get(const std::string&) { return nullptr; }
+#endif
+};
+
+template<>
+struct Vector_kernels<float>
+{
+#if ROW_UPDATE_X86
+	static Row_kernel<float> Get(const std::string& name)
+	{
+		if (name == "sse2") return Update_row_sse2_float;
+		if (name == "avx2") return Update_row_avx2_float;
+		if (name == "avx512") return Update_row_avx512_float;
+		return nullptr;
+	}
+#else
+	static Row_kernel<float> Get(const std::string&) { return nullptr; }
+#endif
+};
+
+template<>
+struct Vector_kernels<Fixed_point>
+{
+#if ROW_UPDATE_X86
+	static Row_kernel<Fixed_point> Get(const std::string& name)
+	{
+		//SSE2 has no 64-bit integer comparison
+		if (name == "avx2") return Update_row_avx2_fixed;
+		if (name == "avx512") return Update_row_avx512_fixed;
+		return nullptr;
+	}
+#else
+	static Row_kernel<Fixed_point> Get(const std::string&) { return nullptr; }
+#endif
+};
+
+//Return the kernel with the given name, or nullptr if it is not available on this processor
+template<typename T>
+inline Row_kernel<T> Get_row_kernel(const std::string& name)
+{
+	if (!Cpu_supports(name))
+	{
+		return nullptr;
+	}
+	if (name == "scalar")
+	{
+		return Update_row_scalar<T>;
+	}
+	return Vector_kernels<T>::Get(name);
+}
+
+//Names of all kernels, from slowest to fastest
+const char* const row_kernel_names[] = { "scalar", "sse2", "avx2", "avx512" };
+
+//Return the name of the fastest kernel supported by this processor
+template<typename T>
+inline std::string Best_row_kernel()
+{
+	std::string best = "scalar";
+	for (const char* name : row_kernel_names)
+	{
+		if (Get_row_kernel<T>(name) != nullptr)
+		{
+			best = name;
+		}
+	}
+	return best;
+}
+
+//Batch kernels: the rows of batch_lanes<T> independent instances are interleaved, budget b of lane l is at row[b * batch_lanes<T> + l].
+//They compute, for every budget b in [0, count) and lane l: new_row[b][l] = max(old_row[b][l], p[l] * (r[l] + old_row[b - cost[l]][l])),
+//where including is only possible if b >= cost[l], and set bit l of masks[b] if including the job of lane l is strictly better.
+//A lane without a job gets cost 0, probability 1 and revenue 0, which never changes its row.
+template<typename T>
+constexpr int batch_lanes = 64 / sizeof(T); //One cache line of revenues per budget: 8 doubles or 16 floats
+
+template<typename T>
+using Batch_kernel = void (*)(const T* old_row, T* new_row, uint16_t* masks, int count, const int* cost, const double* p, const double* r);
+
+template<typename T>
+inline void Update_batch_scalar(const T* old_row, T* new_row, uint16_t* masks, int count, const int* cost, const double* p, const double* r)
+{
+	const int lanes = batch_lanes<T>;
+	std::fill(masks, masks + count, 0);
+	for (int l = 0; l < lanes; l++)
+	{
+		Revenue_policy<T> job(p[l], r[l]);
+		for (int b = 0; b < count; b++)
+		{
+			new_row[(size_t)b * lanes + l] = old_row[(size_t)b * lanes + l];
+			if (b >= cost[l])
+			{
+				T including = job.Include(old_row[(size_t)(b - cost[l]) * lanes + l]);
+				if (including > new_row[(size_t)b * lanes + l])
+				{
+					new_row[(size_t)b * lanes + l] = including;
+					masks[b] |= (uint16_t)(1 << l);
+				}
+			}
+		}
+	}
+}
+
+#if ROW_UPDATE_X86
+//The vector batch kernels gather old_row[b - cost[l]][l] with offsets l - cost[l] * lanes from the start of budget b
+TARGET_AVX2 inline void Update_batch_avx2_double(const double* old_row, double* new_row, uint16_t* masks, int count, const int* cost, const double* p, const double* r)
+{
+	double job_p[8];
+	double job_r[8];
+	int offsets[8];
+	for (int l = 0; l < 8; l++)
+	{
+		Revenue_policy<double> job(p[l], r[l]);
+		job_p[l] = job.p;
+		job_r[l] = job.r;
+		offsets[l] = l - cost[l] * 8;
+	}
+	for (int h = 0; h < 2; h++)
+	{
+		__m256d vp = _mm256_loadu_pd(job_p + 4 * h);
+		__m256d vr = _mm256_loadu_pd(job_r + 4 * h);
+		__m128i index = _mm_loadu_si128((const __m128i*)(offsets + 4 * h));
+		__m128i vcost = _mm_loadu_si128((const __m128i*)(cost + 4 * h));
+		for (int b = 0; b < count; b++)
+		{
+			const double* row = old_row + (size_t)b * 8 + 4 * h;
+			__m256d valid = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm_cmpgt_epi32(_mm_set1_epi32(b + 1), vcost)));
+			__m256d skipping = _mm256_loadu_pd(row);
+			__m256d shifted = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), row - 4 * h, index, valid, 8);
+			__m256d including = _mm256_mul_pd(vp, _mm256_add_pd(vr, shifted));
+			__m256d take = _mm256_and_pd(valid, _mm256_cmp_pd(including, skipping, _CMP_GT_OQ));
+			_mm256_storeu_pd(new_row + (size_t)b * 8 + 4 * h, _mm256_blendv_pd(skipping, including, take));
+			int bits = _mm256_movemask_pd(take) << (4 * h);
+			masks[b] = (uint16_t)(h == 0 ? bits : (masks[b] | bits));
+		}
+	}
+}
+
+TARGET_AVX2 inline void Update_batch_avx2_float(const float* old_row, float* new_row, uint16_t* masks, int count, const int* cost, const double* p, const double* r)
+{
+	float job_p[16];
+	float job_r[16];
+	int offsets[16];
+	for (int l = 0; l < 16; l++)
+	{
+		Revenue_policy<float> job(p[l], r[l]);
+		job_p[l] = job.p;
+		job_r[l] = job.r;
+		offsets[l] = l - cost[l] * 16;
+	}
+	for (int h = 0; h < 2; h++)
+	{
+		__m256 vp = _mm256_loadu_ps(job_p + 8 * h);
+		__m256 vr = _mm256_loadu_ps(job_r + 8 * h);
+		__m256i index = _mm256_loadu_si256((const __m256i*)(offsets + 8 * h));
+		__m256i vcost = _mm256_loadu_si256((const __m256i*)(cost + 8 * h));
+		for (int b = 0; b < count; b++)
+		{
+			const float* row = old_row + (size_t)b * 16 + 8 * h;
+			__m256 valid = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(b + 1), vcost));
+			__m256 skipping = _mm256_loadu_ps(row);
+			__m256 shifted = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), row - 8 * h, index, valid, 4);
+			__m256 including = _mm256_mul_ps(vp, _mm256_add_ps(vr, shifted));
+			__m256 take = _mm256_and_ps(valid, _mm256_cmp_ps(including, skipping, _CMP_GT_OQ));
+			_mm256_storeu_ps(new_row + (size_t)b * 16 + 8 * h, _mm256_blendv_ps(skipping, including, take));
+			int bits = _mm256_movemask_ps(take) << (8 * h);
+			masks[b] = (uint16_t)(h == 0 ? bits : (masks[b] | bits));
+		}
+	}
+}
+
+TARGET_AVX512 inline void Update_batch_avx512_double(const double* old_row, double* new_row, uint16_t* masks, int count, const int* cost, const double* p, const double* r)
+{
+	double job_p[8];
+	double job_r[8];
+	int offsets[8];
+	for (int l = 0; l < 8; l++)
+	{
+		Revenue_policy<double> job(p[l], r[l]);
+		job_p[l] = job.p;
+		job_r[l] = job.r;
+		offsets[l] = l - cost[l] * 8;
+	}
+	__m512d vp = _mm512_loadu_pd(job_p);
+	__m512d vr = _mm512_loadu_pd(job_r);
+	__m256i index = _mm256_loadu_si256((const __m256i*)offsets);
+	__m512i vcost = _mm512_maskz_loadu_epi32(0xff, cost);
+	for (int b = 0; b < count; b++)
+	{
+		__mmask8 valid = (__mmask8)_mm512_cmpge_epi32_mask(_mm512_set1_epi32(b), vcost);
+		const double* row = old_row + (size_t)b * 8;
+		__m512d skipping = _mm512_loadu_pd(row);
+		__m512d shifted = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), valid, index, row, 8);
+		__m512d including = _mm512_mul_pd(vp, _mm512_add_pd(vr, shifted));
+		__mmask8 take = _mm512_mask_cmp_pd_mask(valid, including, skipping, _CMP_GT_OQ);
+		_mm512_storeu_pd(new_row + (size_t)b * 8, _mm512_mask_blend_pd(take, skipping, including));
+		masks[b] = take;
+	}
+}
+
+TARGET_AVX512 inline void Update_batch_avx512_float(const float* old_row, float* new_row, uint16_t* masks, int count, const int* cost, const double* p, const double* r)
+{
+	float job_p[16];
+	float job_r[16];
+	int offsets[16];
+	for (int l = 0; l < 16; l++)
+	{
+		Revenue_policy<float> job(p[l], r[l]);
+		job_p[l] = job.p;
+		job_r[l] = job.r;
+		offsets[l] = l - cost[l] * 16;
+	}
+	__m512 vp = _mm512_loadu_ps(job_p);
+	__m512 vr = _mm512_loadu_ps(job_r);
+	__m512i index = _mm512_loadu_si512(offsets);
+	__m512i vcost = _mm512_loadu_si512(cost);
+	for (int b = 0; b < count; b++)
+	{
+		__mmask16 valid = _mm512_cmpge_epi32_mask(_mm512_set1_epi32(b), vcost);
+		const float* row = old_row + (size_t)b * 16;
+		__m512 skipping = _mm512_loadu_ps(row);
+		__m512 shifted = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), valid, index, row, 4);
+		__m512 including = _mm512_mul_ps(vp, _mm512_add_ps(vr, shifted));
+		__mmask16 take = _mm512_mask_cmp_ps_mask(valid, including, skipping, _CMP_GT_OQ);
+		_mm512_storeu_ps(new_row + (size_t)b * 16, _mm512_mask_blend_ps(take, skipping, including));
+		masks[b] = take;
+	}
+}
+#endif
+
+//Vector batch kernels of every numeric policy, nullptr if there is none for an instruction set
+template<typename T>
+struct Vector_batch_kernels
+{
+	static Batch_kernel<T> Get(const std::string&) { return nullptr; }
+};
+
+#if ROW_UPDATE_X86
+template<>
+struct Vector_batch_kernels<double>
+{
+	static Batch_kernel<double> Get(const std::string& name)
+	{
+		if (name == "avx2") return Update_batch_avx2_double;
+		if (name == "avx512") return Update_batch_avx512_double;
+		return nullptr;
+	}
+};
+
+template<>
+struct Vector_batch_kernels<float>
+{
+	static Batch_kernel<float> Get(const std::string& name)
+	{
+		if (name == "avx2") return Update_batch_avx2_float;
+		if (name == "avx512") return Update_batch_avx512_float;
+		return nullptr;
+	}
+};
+#endif
+
+//Return the batch kernel for the given instruction set, the scalar one if there is no vector version for it,
+//or nullptr if the instruction set is not available on this processor
+template<typename T>
+inline Batch_kernel<T> Get_batch_kernel(const std::string& name)
+{
+	if (!Cpu_supports(name))
+	{
+		return nullptr;
+	}
+	Batch_kernel<T> kernel = Vector_batch_kernels<T>::Get(name);
+	return kernel != nullptr ? kernel : Update_batch_scalar<T>;
+}
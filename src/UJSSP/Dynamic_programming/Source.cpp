@@ -1,101 +1,244 @@
-#include "Data.h"
+﻿#include "Data.h"
+#include "Row_update.h"
+#include "Decision_spill.h"
+#include "Budget_frontier.h"
+#include "Thread_pool.h"
 #include<iostream>
 #include<fstream>
 #include<vector>
 #include<chrono>
+#include<cstdint>
+#include<cstdlib>
+#include<cmath>
+#include<string>
+#include<algorithm>
+#include<memory>
 
+#ifndef DP_NUMERIC
+#define DP_NUMERIC 2 // 1 is float, 2 is double, 3 is 64-bit fixed-point (see FIXED_POINT_SCALE in Row_update.h)
+#endif
 
-int main(int argc, char* argv[])
-{
-	if (argc != 2)
-	{
-		std::cout << "Usage: " << argv[0] << " < filename > " << std::endl;
-		return 0;
-	}
+#if DP_NUMERIC == 1
+typedef float Revenue;
+#elif DP_NUMERIC == 3
+typedef Fixed_point Revenue;
+#else
+typedef double Revenue;
+#endif
+typedef Revenue_policy<Revenue> Policy;
 
-	Data::ReadData(argv[1]);
-	Data::SortData();
-	Data::Print_Data();
 
-	int c_max = 0;
-	for (int i = 0; i < Data::n; i++)
-	{
-		c_max += Data::c[i];
-	}
+Row_kernel<Revenue> row_kernel = Update_row_scalar<Revenue>; //Kernel used for the row updates, selected at runtime
+Thread_pool* pool = nullptr; //Threads that share the budgets of every row update
 
-	//Start timer
-	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+const int budgets_per_line = 512; //Budgets whose decisions fill one 64-byte cache line, threads never share a line
+const int tile_budgets = 4096; //Budgets per tile in the temporal blocking, the rows of a tile stay in cache
+
+//Process job n for all budgets 0..width: rev_new[b] is the best expected revenue of jobs n..Data::n-1 with budget b
+//If row_decisions is given, the take/skip bit of every budget is stored in it
+//The budgets are split into one contiguous range per thread, so every thread keeps working on the same part of the rows
+void Update_row(int n, const std::vector<Revenue>& rev_old, std::vector<Revenue>& rev_new, uint64_t* row_decisions, int width)
+{
+	pool->Run([&](int thread, int nr_threads)
+		{
+			int nr_lines = width / budgets_per_line + 1;
+			int begin = (int)((long long)nr_lines * thread / nr_threads) * budgets_per_line;
+			int end = std::min(width + 1, (int)((long long)nr_lines * (thread + 1) / nr_threads) * budgets_per_line);
+			if (begin >= end)
+			{
+				return;
+			}
+			uint64_t* bits = row_decisions != nullptr ? row_decisions + begin / 64 : nullptr;
+			row_kernel(rev_old.data() + begin, rev_new.data() + begin, bits, std::max(0, Data::c[n] - begin), end - begin, Data::c[n], Data::p[n], (double)Data::r[n]);
+		});
+}
 
-	std::vector<std::vector<double>> rev(2, std::vector<double>(c_max + 1)); //Expected revenues; only store last 2 to save memory
-	std::vector<std::vector<std::vector<bool>>> solutions(2, std::vector<std::vector<bool>>(c_max + 1, std::vector<bool>(Data::n, false))); //Corresponding solution vectors
-	//Initialize for n
-	for (int b = 0; b < Data::c[Data::n - 1]; b++)
+//Process jobs last_job down to first_job for budgets 0..width in a single pass over the rows (temporal blocking)
+//rev_in holds the revenues of the jobs after last_job, rev_out receives the revenues of the jobs from first_job on
+//and row_decisions[l] receives the decisions of job last_job - l, if it is not nullptr.
+//Every thread moves its budget range through all jobs of the block one tile at a time, keeping the rows of the
+//intermediate jobs in small buffers that stay in cache. A job only needs the previous row at budgets b and b - c,
+//so each buffer also keeps the last budgets of the previous tile. In the first tile of a range the intermediate rows
+//start earlier by the costs of the later jobs (trapezoidal tiles), so no thread needs budgets computed by another thread.
+void Update_block(int first_job, int last_job, const std::vector<Revenue>& rev_in, std::vector<Revenue>& rev_out, const std::vector<uint64_t*>& row_decisions, int width)
+{
+	int nr_levels = last_job - first_job + 1;
+	std::vector<int> extra(nr_levels, 0); //Level l (job last_job - l) starts extra[l] budgets before the range of a thread
+	int max_cost = 0;
+	for (int l = nr_levels - 2; l >= 0; l--)
 	{
-		rev[0][b] = 0;
+		extra[l] = extra[l + 1] + Data::c[last_job - l - 1];
 	}
-	for (int b = Data::c[Data::n - 1]; b <= c_max; b++)
+	for (int l = 0; l < nr_levels; l++)
 	{
-		rev[0][b] = (Data::p[Data::n - 1] * ((double) Data::r[Data::n - 1]));
-		solutions[0][b][Data::n - 1] = true;
+		max_cost = std::max(max_cost, Data::c[last_job - l]);
 	}
-	//Dynamic programming
-	int index = 0;
-	int old_index = 1;
-	for (int n = Data::n - 2; n >= 0; n--)
-	{
-		//Find indices
-		if (old_index == 0) { old_index = 1; index = 0; }
-		else { old_index = 0; index = 1; }
+	int halo = std::max(max_cost, extra[0]);
+	int tile = std::max(tile_budgets, (max_cost / budgets_per_line + 1) * budgets_per_line);
 
-		for (int b = 0; b <= c_max; b++)
+	pool->Run([&](int thread, int nr_threads)
 		{
-			rev[index][b] = rev[old_index][b];
-			double including = 0;
-			if (Data::c[n] <= b) // Try including job if possible
+			int nr_lines = width / budgets_per_line + 1;
+			int range_begin = (int)((long long)nr_lines * thread / nr_threads) * budgets_per_line;
+			int range_end = std::min(width + 1, (int)((long long)nr_lines * (thread + 1) / nr_threads) * budgets_per_line);
+			if (range_begin >= range_end)
+			{
+				return;
+			}
+
+			//Buffer of level l holds budget B0 + i at position halo + i for the current tile starting at B0
+			static thread_local std::vector<Revenue> buffers;
+			int stride = halo + tile;
+			buffers.resize((size_t)std::max(1, nr_levels - 1) * stride);
+
+			for (int tile_begin = range_begin; tile_begin < range_end; tile_begin += tile)
 			{
-				including = Data::p[n] * (Data::r[n] + rev[old_index][b - Data::c[n]]);
+				int tile_end = std::min(tile_begin + tile, range_end);
+				for (int l = 0; l < nr_levels; l++)
+				{
+					int n = last_job - l;
+					int begin = tile_begin == range_begin ? std::max(0, range_begin - extra[l]) : tile_begin;
+					const Revenue* in = l == 0 ? rev_in.data() + begin : buffers.data() + (size_t)(l - 1) * stride + halo + (begin - tile_begin);
+					Revenue* out = l == nr_levels - 1 ? rev_out.data() + begin : buffers.data() + (size_t)l * stride + halo + (begin - tile_begin);
+
+					//Budgets before the range of this thread are only needed as input for the next job
+					if (begin < tile_begin)
+					{
+						row_kernel(in, out, nullptr, std::max(0, Data::c[n] - begin), tile_begin - begin, Data::c[n], Data::p[n], (double)Data::r[n]);
+						in += tile_begin - begin;
+						out += tile_begin - begin;
+					}
+					uint64_t* bits = row_decisions[l] != nullptr ? row_decisions[l] + tile_begin / 64 : nullptr;
+					row_kernel(in, out, bits, std::max(0, Data::c[n] - tile_begin), tile_end - tile_begin, Data::c[n], Data::p[n], (double)Data::r[n]);
+				}
+
+				//Keep the last budgets of this tile in front of the next one
+				for (int l = 0; l < nr_levels - 1 && tile_end < range_end; l++)
+				{
+					Revenue* buffer = buffers.data() + (size_t)l * stride;
+					std::copy(buffer + halo + tile - max_cost, buffer + halo + tile, buffer + halo - max_cost);
+				}
 			}
-			if (including > rev[index][b]) // If including is better, do it
+		});
+}
+
+//Compare the plain row sweep with the temporal blocking for row widths from 10^4 to 10^7 budgets
+void Benchmark_blocking(int block_jobs)
+{
+	for (int width = 10000; width <= 10000000; width *= 10)
+	{
+		//Sweep about 5 * 10^8 budget-cells, using the jobs of the instance from the last one on
+		int nr_jobs = std::min(Data::n, std::max(block_jobs, (int)(5e8 / width)));
+		nr_jobs = std::max(1, nr_jobs / block_jobs * block_jobs);
+		std::vector<double> speed(2);
+		std::vector<std::vector<Revenue>> result(2);
+		for (int blocked = 0; blocked <= 1; blocked++)
+		{
+			int jobs_per_pass = blocked ? block_jobs : 1;
+			std::vector<Revenue> rev_old(width + 1, 0);
+			std::vector<Revenue> rev_new(width + 1);
+			std::vector<uint64_t> decision_rows((size_t)jobs_per_pass * (width / 64 + 1));
+			std::vector<uint64_t*> row_decisions;
+			for (int l = 0; l < jobs_per_pass; l++)
 			{
-				rev[index][b] = including;
-				solutions[index][b] = solutions[old_index][b - Data::c[n]];
-				solutions[index][b][n] = true;
+				row_decisions.push_back(&decision_rows[(size_t)l * (width / 64 + 1)]);
 			}
-			else
+			std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+			for (int n = Data::n - 1; n >= Data::n - nr_jobs; n -= jobs_per_pass)
 			{
-				solutions[index][b] = solutions[old_index][b];
+				int first_job = std::max(Data::n - nr_jobs, n - jobs_per_pass + 1);
+				Update_block(first_job, n, rev_old, rev_new, row_decisions, width);
+				std::swap(rev_old, rev_new);
 			}
+			std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+			double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1).count();
+			speed[blocked] = (double)nr_jobs * (width + 1) / seconds;
+			result[blocked] = rev_old;
 		}
+		std::cout << "width " << width << ":\tplain " << speed[0] << ", blocked (" << block_jobs << " jobs) " << speed[1] << " budget-cells per second (" << speed[1] / speed[0] << "x)";
+		if (result[0] != result[1])
+		{
+			std::cout << "\tWARNING: results differ";
+		}
+		std::cout << std::endl;
 	}
+}
 
-	//Find optimal solution, by looking at all possible budgets
-	double optimal_profit = 0;
-	int optimal_budget = 0;
-	for (int b = 0; b < c_max + 1; b++)
+//Row is only valid for budgets 0..old_width and is constant after that, so fill it up to new_width
+void Extend_row(std::vector<Revenue>& row, int old_width, int new_width)
+{
+	if (new_width > old_width)
+	{
+		std::fill(row.begin() + old_width + 1, row.begin() + new_width + 1, row[old_width]);
+	}
+}
+
+//Time a full sweep over all jobs and budgets with every kernel supported by this processor
+void Benchmark_kernels(int c_max)
+{
+	std::vector<Revenue> scalar_result;
+	double scalar_speed = 0;
+	for (const char* name : row_kernel_names)
 	{
-		if (rev[index][b] - b > optimal_profit)
+		Row_kernel<Revenue> kernel = Get_row_kernel<Revenue>(name);
+		if (kernel == nullptr)
 		{
-			optimal_profit = rev[index][b] - b;
-			optimal_budget = b;
+			std::cout << name << ":	not supported" << std::endl;
+			continue;
+		}
+		std::vector<Revenue> rev_old(c_max + 1, 0);
+		std::vector<Revenue> rev_new(c_max + 1);
+		std::vector<uint64_t> row_decisions(c_max / 64 + 1);
+		std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+		for (int n = Data::n - 1; n >= 0; n--)
+		{
+			kernel(rev_old.data(), rev_new.data(), row_decisions.data(), Data::c[n], c_max + 1, Data::c[n], Data::p[n], (double)Data::r[n]);
+			std::swap(rev_old, rev_new);
 		}
+		std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+		double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1).count();
+		double speed = (double)Data::n * (c_max + 1) / seconds;
+		if (scalar_result.empty())
+		{
+			scalar_result = rev_old;
+			scalar_speed = speed;
+		}
+		std::cout << name << ":	" << speed << " budget-cells per second (" << speed / scalar_speed << "x scalar)";
+		if (rev_old != scalar_result)
+		{
+			std::cout << "\tWARNING: result differs from scalar kernel";
+		}
+		std::cout << std::endl;
 	}
 
-	//Stop timer
-	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
-
-	//Print solution
-	std::cout << "Optimal solution = " << optimal_profit << std::endl;
-	std::cout << "[ ";
-	for (int i = 0; i < Data::n - 1; i++)
+	//Time the fastest kernel on all threads of the pool
+	if (pool->Size() > 1)
 	{
-		if (solutions[index][optimal_budget][i]) std::cout << " 1 ,";
-		else std::cout << " 0 ,";
+		std::vector<Revenue> rev_old(c_max + 1, 0);
+		std::vector<Revenue> rev_new(c_max + 1);
+		std::vector<uint64_t> row_decisions(c_max / 64 + 8);
+		std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+		for (int n = Data::n - 1; n >= 0; n--)
+		{
+			Update_row(n, rev_old, rev_new, row_decisions.data(), c_max);
+			std::swap(rev_old, rev_new);
+		}
+		std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+		double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1).count();
+		double speed = (double)Data::n * (c_max + 1) / seconds;
+		std::cout << pool->Size() << " threads:\t" << speed << " budget-cells per second (" << speed / scalar_speed << "x scalar)";
+		if (rev_old != scalar_result)
+		{
+			std::cout << "\tWARNING: result differs from scalar kernel";
+		}
+		std::cout << std::endl;
 	}
-	if (!solutions[index][optimal_budget][Data::n - 1]) std::cout << " 0 ]" << std::endl;
-	else std::cout << " 1 ]" << std::endl;
+}
 
-	//Write results to file
-	std::string inputFilename = argv[1];
+//Write the solution of the instance in Data to the output file that belongs to the input file
+int Write_output(const std::string& filename, double profit, double seconds, const std::vector<bool>& solution)
+{
+	std::string inputFilename = filename;
 	std::string baseFilename;
 	std::string outputFilename;
 
@@ -134,13 +277,689 @@ int main(int argc, char* argv[])
 	}
 
 	// Write to output file
-	outFile << optimal_profit << std::endl;
-	outFile << std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1).count() << std::endl;
+	outFile << profit << std::endl;
+	outFile << seconds << std::endl;
 	outFile << Data::n << std::endl;
 	for (int i = 0; i < Data::n; i++)
 	{
-		outFile << solutions[index][optimal_budget][i] << "\t" << Data::r[i] << "\t" << Data::c[i] << "\t" << Data::p[i] << std::endl;
+		outFile << solution[i] << "\t" << Data::r[i] << "\t" << Data::c[i] << "\t" << Data::p[i] << std::endl;
 	}
 
 	return 0;
+}
+
+//Instance of the batch mode, with its jobs sorted by ratio
+struct Instance
+{
+	std::string filename;
+	int n = 0;
+	std::vector<double> p;
+	std::vector<int> c;
+	std::vector<int> r;
+	int c_sum = 0; //Cost of all jobs
+	int max_budget = 0; //Bound on the optimal budget, as in the single instance mode
+	double profit = 0;
+	std::vector<bool> solution;
+};
+
+//Batch mode: solve all instances in the list file (one data file per line), batch_lanes<Revenue> instances at a time.
+//The rows of the instances of a group are interleaved so that one kernel call updates all of them, each with its own job.
+//Instances are grouped in order of (n, total cost), so the lanes of a group need about as many jobs and budgets,
+//and every row only sweeps the largest width of its lanes. Groups are independent and are divided over the threads of the pool.
+int Solve_batch(const char* list_filename, const std::string& kernel_name)
+{
+	Batch_kernel<Revenue> batch_kernel = Get_batch_kernel<Revenue>(kernel_name);
+	if (batch_kernel == nullptr)
+	{
+		std::cout << "Kernel " << kernel_name << " is not supported on this processor." << std::endl;
+		return 1;
+	}
+	const int lanes = batch_lanes<Revenue>;
+
+	//Read all instances, without echoing the data files
+	std::ifstream list_file(list_filename);
+	if (!list_file)
+	{
+		std::cout << "Unable to open list file." << std::endl;
+		return 1;
+	}
+	std::vector<Instance> instances;
+	std::string line;
+	while (std::getline(list_file, line))
+	{
+		if (line.empty())
+		{
+			continue;
+		}
+		std::streambuf* echo = std::cout.rdbuf(nullptr);
+		Data::n = 0;
+		Data::ReadData(line.c_str());
+		std::cout.rdbuf(echo);
+		if (Data::n == 0)
+		{
+			std::cout << "Unable to read instance " << line << std::endl;
+			return 1;
+		}
+		Data::SortData();
+		Instance instance;
+		instance.filename = line;
+		instance.n = Data::n;
+		instance.p = Data::p;
+		instance.c = Data::c;
+		instance.r = Data::r;
+
+		//Cap the budgets at floor(max_revenue - lb_profit) + 1 with the greedy profit lb_profit, as in the single instance mode
+		double max_revenue = 0;
+		double greedy_revenue = 0;
+		double greedy_cost = 0;
+		for (int n = Data::n - 1; n >= 0; n--)
+		{
+			instance.c_sum += Data::c[n];
+			max_revenue = Data::p[n] * (Data::r[n] + max_revenue);
+			double including = Data::p[n] * (Data::r[n] + greedy_revenue);
+			if (including - Data::c[n] > greedy_revenue)
+			{
+				greedy_revenue = including;
+				greedy_cost += Data::c[n];
+			}
+		}
+		instance.max_budget = (int)std::min((double)instance.c_sum, std::floor(max_revenue - (greedy_revenue - greedy_cost)) + 1);
+		instances.push_back(instance);
+	}
+
+	//Lanes of a group take turns in this order, the results are written in the order of the list file
+	std::vector<int> order(instances.size());
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		order[i] = (int)i;
+	}
+	std::sort(order.begin(), order.end(), [&](int a, int b)
+		{
+			return std::make_pair(instances[a].n, instances[a].c_sum) < std::make_pair(instances[b].n, instances[b].c_sum);
+		});
+	int nr_groups = ((int)instances.size() + lanes - 1) / lanes;
+	std::cout << "Batch of " << instances.size() << " instances in " << nr_groups << " groups of " << lanes << " lanes, using " << kernel_name << " kernel and " << pool->Size() << " thread(s)" << std::endl;
+
+	//Start timer
+	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+
+	pool->Run([&](int thread, int nr_threads)
+		{
+			for (int group = thread; group < nr_groups; group += nr_threads)
+			{
+				int first = group * lanes;
+				int nr_lanes = std::min(lanes, (int)instances.size() - first);
+				std::vector<Instance*> lane(nr_lanes);
+				for (int l = 0; l < nr_lanes; l++)
+				{
+					lane[l] = &instances[order[first + l]];
+				}
+
+				//All lanes share the jobs 0..nr_jobs-1, lanes with fewer jobs are padded. Row n of lane l is only valid for budgets
+				//up to min(cost of its jobs n..end, its budget cap), so row n sweeps the budgets 0..width[n], the largest of these.
+				int nr_jobs = 0;
+				for (int l = 0; l < nr_lanes; l++)
+				{
+					nr_jobs = std::max(nr_jobs, lane[l]->n);
+				}
+				std::vector<int> width(nr_jobs + 1, 0);
+				std::vector<int> suffix_cost(nr_lanes, 0);
+				for (int n = nr_jobs - 1; n >= 0; n--)
+				{
+					for (int l = 0; l < nr_lanes; l++)
+					{
+						if (n < lane[l]->n)
+						{
+							suffix_cost[l] += lane[l]->c[n];
+						}
+						width[n] = std::max(width[n], std::min(suffix_cost[l], lane[l]->max_budget));
+					}
+				}
+				std::vector<size_t> mask_offset(nr_jobs + 1, 0); //Masks of row n are at mask_offset[n]..mask_offset[n] + width[n]
+				for (int n = 0; n < nr_jobs; n++)
+				{
+					mask_offset[n + 1] = mask_offset[n] + width[n] + 1;
+				}
+				std::vector<Revenue> rev_old((size_t)(width[0] + 1) * lanes, 0);
+				std::vector<Revenue> rev_new((size_t)(width[0] + 1) * lanes);
+				std::vector<uint16_t> masks(mask_offset[nr_jobs]);
+				std::vector<int> cost(lanes);
+				std::vector<double> prob(lanes);
+				std::vector<double> revenue(lanes);
+				for (int n = nr_jobs - 1; n >= 0; n--)
+				{
+					for (int l = 0; l < lanes; l++)
+					{
+						bool job = l < nr_lanes && n < lane[l]->n;
+						cost[l] = job ? lane[l]->c[n] : 0;
+						prob[l] = job ? lane[l]->p[n] : 1.0;
+						revenue[l] = job ? lane[l]->r[n] : 0.0;
+					}
+
+					//Every lane of the previous row is constant after budget width[n + 1] or only read above its own cap, see Extend_row
+					for (int b = width[n + 1] + 1; b <= width[n]; b++)
+					{
+						std::copy(rev_old.begin() + (size_t)width[n + 1] * lanes, rev_old.begin() + (size_t)(width[n + 1] + 1) * lanes, rev_old.begin() + (size_t)b * lanes);
+					}
+					batch_kernel(rev_old.data(), rev_new.data(), &masks[mask_offset[n]], width[n] + 1, cost.data(), prob.data(), revenue.data());
+					std::swap(rev_old, rev_new);
+				}
+
+				//Find the optimal budget of every lane, backtrack its solution and evaluate it exactly in double precision
+				for (int l = 0; l < nr_lanes; l++)
+				{
+					Instance& instance = *lane[l];
+					double best = 0;
+					int budget = 0;
+					for (int b = 0; b <= std::min(instance.c_sum, instance.max_budget); b++)
+					{
+						if (Policy::To_double(rev_old[(size_t)b * lanes + l]) - b > best)
+						{
+							best = Policy::To_double(rev_old[(size_t)b * lanes + l]) - b;
+							budget = b;
+						}
+					}
+					instance.solution.assign(instance.n, false);
+					double probability = 1.0;
+					for (int n = 0; n < instance.n; n++)
+					{
+						//Decisions are the same for all budgets after the cost of the remaining jobs
+						if ((masks[mask_offset[n] + std::min(budget, width[n])] >> l) & 1)
+						{
+							instance.solution[n] = true;
+							budget -= instance.c[n];
+							probability *= instance.p[n];
+							instance.profit += probability * instance.r[n] - instance.c[n];
+						}
+					}
+				}
+			}
+		});
+
+	//Stop timer
+	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+	double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1).count();
+	std::cout << "Solved " << instances.size() << " instances in " << seconds << " seconds (" << instances.size() / seconds << " instances per second)" << std::endl;
+
+	//Write results to file, every instance gets an equal share of the time
+	for (Instance& instance : instances)
+	{
+		std::cout << instance.filename << "\t" << instance.profit << std::endl;
+		Data::n = instance.n;
+		Data::p = instance.p;
+		Data::c = instance.c;
+		Data::r = instance.r;
+		if (Write_output(instance.filename, instance.profit, seconds / instances.size(), instance.solution) != 0)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+//Query mode: answer the spending caps read from standard input (one per line) with the frontier file of a previous DP,
+//printing the cap, the exact profit and cost of the best selection within the cap and the selected jobs (in ratio order)
+int Query_frontier(const char* frontier_filename)
+{
+	Frontier_file frontier;
+	if (!frontier.Open(frontier_filename))
+	{
+		std::cout << "Unable to read frontier file " << frontier_filename << std::endl;
+		return 1;
+	}
+	std::vector<long long> caps;
+	long long cap;
+	while (std::cin >> cap)
+	{
+		caps.push_back(cap);
+	}
+
+	//Start timer
+	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+
+	std::vector<std::vector<int>> selections(caps.size());
+	std::vector<int> costs(caps.size());
+	std::vector<double> profits(caps.size());
+	for (size_t q = 0; q < caps.size(); q++)
+	{
+		costs[q] = frontier.Query(caps[q], selections[q]);
+		double prob = 1.0;
+		for (int i : selections[q])
+		{
+			prob *= frontier.p[i];
+			profits[q] += prob * frontier.r[i] - frontier.c[i];
+		}
+	}
+
+	//Stop timer
+	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+	double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1).count();
+
+	for (size_t q = 0; q < caps.size(); q++)
+	{
+		std::cout << caps[q] << "\t" << profits[q] << "\t" << costs[q] << "\t";
+		for (size_t k = 0; k < selections[q].size(); k++)
+		{
+			std::cout << (k > 0 ? " " : "") << selections[q][k];
+		}
+		std::cout << "\n";
+	}
+	std::cerr << "Answered " << caps.size() << " queries on " << frontier.n << " jobs in " << seconds << " seconds (" << (caps.empty() ? 0 : 1e6 * seconds / caps.size()) << " microseconds per query)" << std::endl;
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	//Read options
+	double memory_mb = 0; //Memory limit in MB for the revenue rows and decisions, 0 means no limit
+	std::string kernel_name = Best_row_kernel<Revenue>(); //Row update kernel, by default the fastest one supported
+	bool benchmark = false; //Only time the row update kernels
+	int nr_threads = 1; //Number of threads used for every row update
+	int block_jobs = 1; //Number of jobs processed in one pass over the rows
+	double epsilon = 0; //Approximation mode: find a (1 - epsilon)-optimal solution, 0 means exact
+	const char* batch_list = nullptr; //Batch mode: file with one data file per line, solved in groups of batch_lanes instances
+	const char* spill_filename = nullptr; //Spill the decisions of all jobs to this file instead of keeping them in memory
+	const char* frontier_filename = nullptr; //Write the revenue of every budget and the decisions to this file for budget-capped queries
+	const char* query_filename = nullptr; //Query mode: answer spending caps from standard input with this frontier file
+	const char* filename = nullptr;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--memory-mb" && i + 1 < argc)
+		{
+			memory_mb = std::atof(argv[++i]);
+		}
+		else if (arg == "--kernel" && i + 1 < argc)
+		{
+			kernel_name = argv[++i];
+		}
+		else if (arg == "--threads" && i + 1 < argc)
+		{
+			nr_threads = std::atoi(argv[++i]);
+		}
+		else if (arg == "--epsilon" && i + 1 < argc)
+		{
+			epsilon = std::atof(argv[++i]);
+		}
+		else if (arg == "--block-jobs" && i + 1 < argc)
+		{
+			block_jobs = std::max(1, std::atoi(argv[++i]));
+		}
+		else if (arg == "--benchmark")
+		{
+			benchmark = true;
+		}
+		else if (arg == "--spill" && i + 1 < argc)
+		{
+			spill_filename = argv[++i];
+		}
+		else if (arg == "--frontier" && i + 1 < argc)
+		{
+			frontier_filename = argv[++i];
+		}
+		else if (arg == "--query" && i + 1 < argc)
+		{
+			query_filename = argv[++i];
+		}
+		else if (arg == "--batch" && i + 1 < argc)
+		{
+			batch_list = argv[++i];
+		}
+		else if (filename == nullptr)
+		{
+			filename = argv[i];
+		}
+		else
+		{
+			filename = nullptr;
+			break;
+		}
+	}
+	if (query_filename != nullptr && filename == nullptr)
+	{
+		return Query_frontier(query_filename);
+	}
+	if (batch_list != nullptr && filename == nullptr)
+	{
+		Thread_pool thread_pool(nr_threads);
+		pool = &thread_pool;
+		return Solve_batch(batch_list, kernel_name);
+	}
+	if (filename == nullptr)
+	{
+		std::cout << "Usage: " << argv[0] << " [--memory-mb M] [--spill F] [--frontier F] [--threads N] [--block-jobs K] [--epsilon E] [--kernel scalar|sse2|avx2|avx512] [--benchmark] < filename > " << std::endl;
+		std::cout << "   or: " << argv[0] << " [--threads N] [--kernel scalar|sse2|avx2|avx512] --batch < list of filenames > " << std::endl;
+		std::cout << "   or: " << argv[0] << " --query < frontier file > , with one spending cap per line on standard input" << std::endl;
+		return 0;
+	}
+
+	Data::ReadData(filename);
+	Data::SortData();
+	Data::Print_Data();
+
+	int c_max = 0;
+	for (int i = 0; i < Data::n; i++)
+	{
+		c_max += Data::c[i];
+	}
+
+	row_kernel = Get_row_kernel<Revenue>(kernel_name);
+	if (row_kernel == nullptr)
+	{
+		std::cout << "Kernel " << kernel_name << " is not supported on this processor." << std::endl;
+		return 1;
+	}
+	Thread_pool thread_pool(nr_threads);
+	pool = &thread_pool;
+	if (benchmark)
+	{
+		Benchmark_kernels(c_max);
+		if (block_jobs > 1)
+		{
+			Benchmark_blocking(block_jobs);
+		}
+		return 0;
+	}
+	std::cout << "Using " << kernel_name << " kernel and " << pool->Size() << " thread(s)" << std::endl;
+
+	//Start timer
+	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+
+	//Upper bound on the optimal budget: the optimal set S has revenue(S) - cost(S) >= lb_profit,
+	//so cost(S) <= max_revenue - lb_profit, where max_revenue is the revenue of all jobs (adding a job in ratio order never lowers the revenue)
+	//and lb_profit is the profit of a greedy solution that adds jobs from last to first whenever this improves the profit
+	double max_revenue = 0;
+	double greedy_revenue = 0;
+	double greedy_cost = 0;
+	for (int n = Data::n - 1; n >= 0; n--)
+	{
+		max_revenue = Data::p[n] * (Data::r[n] + max_revenue);
+		double including = Data::p[n] * (Data::r[n] + greedy_revenue);
+		if (including - Data::c[n] > greedy_revenue)
+		{
+			greedy_revenue = including;
+			greedy_cost += Data::c[n];
+		}
+	}
+	double lb_profit = greedy_revenue - greedy_cost;
+	if (DP_NUMERIC == 3 && (max_revenue + *std::max_element(Data::r.begin(), Data::r.end())) * FIXED_POINT_SCALE >= 4e18)
+	{
+		std::cout << "Revenues are too large for fixed-point with scale " << FIXED_POINT_SCALE << ", compile with a smaller FIXED_POINT_SCALE." << std::endl;
+		return 1;
+	}
+
+	//Approximation mode: round the costs down to multiples of scale = epsilon * lb_profit / n and solve the scaled problem
+	//Every job loses less than scale of its cost, so the scaled optimum S' satisfies profit(S') >= optimum - n * scale >= (1 - epsilon) * optimum
+	std::vector<int> original_costs = Data::c;
+	double scale = 1;
+	int original_max_budget = (int)std::min((double)c_max, std::floor(max_revenue - lb_profit) + 1);
+	if (epsilon > 0 && lb_profit > 0 && epsilon * lb_profit / Data::n > 1)
+	{
+		scale = epsilon * lb_profit / Data::n;
+		c_max = 0;
+		for (int i = 0; i < Data::n; i++)
+		{
+			Data::c[i] = (int)std::floor(Data::c[i] / scale);
+			c_max += Data::c[i];
+		}
+	}
+	else if (epsilon > 0)
+	{
+		//Rounding to multiples of at most 1 would not change the integer costs
+		std::cout << "Approximation with epsilon = " << epsilon << ": scale " << (lb_profit > 0 ? epsilon * lb_profit / Data::n : 0.0) << " <= 1, running exact" << std::endl;
+	}
+	int max_budget = (int)std::min((double)c_max, std::floor((max_revenue - lb_profit) / scale) + 1);
+
+	//Only budgets up to the cost of all remaining jobs can be reached, the revenues are constant after that
+	std::vector<int> width(Data::n + 1, 0); //Row of job n only needs budgets 0..width[n]
+	int suffix_cost = 0;
+	for (int n = Data::n - 1; n >= 0; n--)
+	{
+		suffix_cost += Data::c[n];
+		width[n] = std::min(suffix_cost, max_budget);
+	}
+	std::cout << "Budgets are capped at " << max_budget << " out of " << c_max << " (greedy profit " << lb_profit << ")" << std::endl;
+
+	int nr_words = (max_budget / budgets_per_line + 1) * (budgets_per_line / 64); //Number of 64-bit words to store one bit per budget, rounded up to whole cache lines
+
+	//Decide how many jobs per segment keep their decisions in memory
+	//If all decisions do not fit, only the revenue rows at the start of every segment are stored (checkpoints)
+	//and the decisions of a segment are recomputed from its checkpoint while backtracking, which costs at most one extra sweep
+	double row_bytes = (double)sizeof(Revenue) * (max_budget + 1);
+	double decision_row_bytes = 8.0 * nr_words;
+	int segment_length = Data::n;
+	if (spill_filename == nullptr && memory_mb > 0 && 2 * row_bytes + Data::n * decision_row_bytes > memory_mb * 1024 * 1024)
+	{
+		//Memory for segment length K: (2 + n / K) revenue rows + K decision rows, minimal for K = sqrt(n * row_bytes / decision_row_bytes)
+		double limit = memory_mb * 1024 * 1024 - 2 * row_bytes;
+		int best_length = std::max(1, (int)std::sqrt(Data::n * row_bytes / decision_row_bytes));
+		segment_length = best_length;
+		for (int k = best_length; k < Data::n; k++)
+		{
+			int nr_checkpoints = (Data::n - 1) / k;
+			if (nr_checkpoints * row_bytes + k * decision_row_bytes > limit)
+			{
+				break;
+			}
+			segment_length = k;
+		}
+		int nr_checkpoints = (Data::n - 1) / segment_length;
+		double needed_mb = (2 * row_bytes + nr_checkpoints * row_bytes + segment_length * decision_row_bytes) / (1024 * 1024);
+		std::cout << "Checkpointed reconstruction: " << nr_checkpoints << " checkpoints, " << segment_length << " jobs per segment, " << needed_mb << " MB" << std::endl;
+		if (needed_mb > memory_mb)
+		{
+			std::cout << "Warning: memory limit of " << memory_mb << " MB cannot be met, using the minimal amount of memory instead." << std::endl;
+		}
+	}
+	int nr_segments = (Data::n - 1) / segment_length + 1; //Segment s holds jobs s * segment_length up to (s + 1) * segment_length - 1
+	if (frontier_filename != nullptr && (nr_segments > 1 || spill_filename != nullptr || scale > 1))
+	{
+		std::cout << "The frontier needs the decisions of all jobs in memory and exact costs, it cannot be combined with a memory limit, a spill file or epsilon." << std::endl;
+		return 1;
+	}
+
+	std::vector<std::vector<Revenue>> rev(2, std::vector<Revenue>(max_budget + 1, 0)); //Expected revenues; only store last 2 to save memory
+	std::vector<std::vector<Revenue>> checkpoints(nr_segments - 1); //Checkpoint s holds the revenues of the jobs after segment s
+	//With a spill file only the decisions of one block are kept in memory, every row is compressed and appended to the file after its block
+	std::unique_ptr<Decision_spill> spill;
+	if (spill_filename != nullptr)
+	{
+		spill.reset(new Decision_spill(spill_filename, nr_words));
+		if (!spill->Is_open())
+		{
+			std::cout << "Unable to open spill file " << spill_filename << std::endl;
+			return 1;
+		}
+	}
+	std::vector<uint64_t> decision_storage((size_t)(spill ? block_jobs : segment_length) * nr_words + 8, 0);
+	uint64_t* decisions = decision_storage.data() + (64 - (uintptr_t)decision_storage.data() % 64) % 64 / 8; //Take/skip bit for every job of one segment and every budget, used to backtrack the solution; aligned to a cache line
+
+	//Dynamic programming, in blocks of at most block_jobs jobs that do not cross a segment
+	int index = 0;
+	int old_index = 1;
+	for (int n = Data::n - 1; n >= 0; )
+	{
+		//Find indices
+		if (old_index == 0) { old_index = 1; index = 0; }
+		else { old_index = 0; index = 1; }
+
+		int segment = n / segment_length;
+		if (segment < nr_segments - 1 && n == (segment + 1) * segment_length - 1)
+		{
+			checkpoints[segment].assign(rev[old_index].begin(), rev[old_index].begin() + width[n + 1] + 1);
+		}
+
+		//Decisions of the first segment are kept, the others are recomputed when backtracking
+		int first_job = std::max(segment * segment_length, n - block_jobs + 1);
+		std::vector<uint64_t*> row_decisions;
+		for (int m = n; m >= first_job; m--)
+		{
+			if (spill)
+			{
+				row_decisions.push_back(&decisions[(size_t)(n - m) * nr_words]);
+			}
+			else
+			{
+				row_decisions.push_back(segment == 0 ? &decisions[(size_t)m * nr_words] : nullptr);
+			}
+		}
+		if (spill)
+		{
+			std::fill(decisions, decisions + (size_t)(n - first_job + 1) * nr_words, 0);
+		}
+		Extend_row(rev[old_index], width[n + 1], width[first_job]);
+		Update_block(first_job, n, rev[old_index], rev[index], row_decisions, width[first_job]);
+		for (size_t l = 0; spill && l < row_decisions.size(); l++)
+		{
+			spill->Append(row_decisions[l]);
+		}
+		n = first_job - 1;
+	}
+
+	//Find optimal solution, by looking at all possible budgets
+	double optimal_profit = 0;
+	int optimal_budget = 0;
+	for (int b = 0; b <= width[0]; b++)
+	{
+		if (Policy::To_double(rev[index][b]) - scale * b > optimal_profit)
+		{
+			optimal_profit = Policy::To_double(rev[index][b]) - scale * b;
+			optimal_budget = b;
+		}
+	}
+
+	//Persist the revenue of every budget and the decisions, so the best selection for any spending cap can be found without a new DP
+	if (frontier_filename != nullptr)
+	{
+		std::vector<double> revenue(width[0] + 1);
+		for (int b = 0; b <= width[0]; b++)
+		{
+			revenue[b] = Policy::To_double(rev[index][b]);
+		}
+		std::vector<const uint64_t*> row_decisions;
+		for (int n = 0; n < Data::n; n++)
+		{
+			row_decisions.push_back(&decisions[(size_t)n * nr_words]);
+		}
+		if (!Write_frontier(frontier_filename, Data::p, Data::c, Data::r, width, revenue, row_decisions))
+		{
+			std::cout << "Unable to write frontier file " << frontier_filename << std::endl;
+			return 1;
+		}
+	}
+
+	//Backtrack the optimal solution from the optimal budget, segment by segment
+	//Budgets beyond the width of a row take the same decision as the last budget of the row
+	std::vector<bool> solution(Data::n, false);
+	if (spill)
+	{
+		std::cout << "Decisions spilled to " << spill_filename << ": " << spill->Bytes_written() / (1024.0 * 1024) << " MB instead of " << spill->Raw_bytes() / (1024.0 * 1024) << " MB" << std::endl;
+		if (!spill->Start_reading())
+		{
+			std::cout << "Unable to read back spill file " << spill_filename << std::endl;
+			return 1;
+		}
+	}
+	int budget = optimal_budget;
+	for (int segment = 0; segment < nr_segments; segment++)
+	{
+		int first_job = segment * segment_length;
+		int last_job = std::min(Data::n, first_job + segment_length) - 1;
+		if (segment >= 1)
+		{
+			//Recompute the decisions of this segment from its checkpoint, only budgets up to the remaining budget are needed
+			std::vector<Revenue> rev_old(1, 0);
+			if (segment < nr_segments - 1)
+			{
+				rev_old.swap(checkpoints[segment]); //Checkpoint is no longer needed afterwards
+			}
+			int old_width = (int)rev_old.size() - 1;
+			rev_old.resize(std::max(old_width, budget) + 1);
+			std::vector<Revenue> rev_new(budget + 1);
+			for (int n = last_job; n >= first_job; )
+			{
+				int block_first = std::max(first_job, n - block_jobs + 1);
+				int new_width = std::min(width[block_first], budget);
+				std::vector<uint64_t*> row_decisions;
+				for (int m = n; m >= block_first; m--)
+				{
+					row_decisions.push_back(&decisions[(size_t)(m - first_job) * nr_words]);
+				}
+				Extend_row(rev_old, old_width, new_width);
+				Update_block(block_first, n, rev_old, rev_new, row_decisions, new_width);
+				std::swap(rev_old, rev_new);
+				old_width = new_width;
+				n = block_first - 1;
+			}
+		}
+		for (int n = first_job; n <= last_job; n++)
+		{
+			int b = std::min(budget, width[n]);
+			const uint64_t* row = &decisions[(size_t)(n - first_job) * nr_words];
+			if (spill)
+			{
+				//Rows come back newest first, which is job 0 first
+				spill->Read_next(decisions);
+				row = decisions;
+			}
+			if ((row[b / 64] >> (b % 64)) & 1)
+			{
+				solution[n] = true;
+				budget -= Data::c[n];
+			}
+		}
+	}
+
+	//Evaluate the selected jobs exactly in double precision on the original costs, so the profit does not depend on the numeric policy or the cost scaling
+	double dp_profit = optimal_profit;
+	Data::c = original_costs;
+	double prob = 1.0;
+	optimal_profit = 0;
+	for (int n = 0; n < Data::n; n++)
+	{
+		if (solution[n])
+		{
+			prob *= Data::p[n];
+			optimal_profit += prob * Data::r[n] - Data::c[n];
+		}
+	}
+	if (DP_NUMERIC != 2)
+	{
+		//The selection is the best one up to the rounding of the DP: its exact profit is at most 2 * error below the optimum
+		std::cout << "Revenues stored as " << Policy::Name() << ": profit in the DP " << dp_profit << ", exact profit " << optimal_profit << ", within " << 2 * Policy::Error(Data::n, max_revenue) << " of the optimum" << std::endl;
+	}
+
+	//In approximation mode, report how much was gained by scaling the costs
+	if (scale > 1)
+	{
+		long long exact_cells = 0;
+		long long scaled_cells = 0;
+		int original_suffix_cost = 0;
+		for (int n = Data::n - 1; n >= 0; n--)
+		{
+			original_suffix_cost += original_costs[n];
+			exact_cells += std::min(original_suffix_cost, original_max_budget) + 1;
+			scaled_cells += width[n] + 1;
+		}
+		std::cout << "Approximation with epsilon = " << epsilon << ": costs rounded down to multiples of " << scale << std::endl;
+		std::cout << "Achieved profit " << optimal_profit << " >= (1 - epsilon) * optimum, a posteriori gap " << (dp_profit - optimal_profit) / optimal_profit << std::endl;
+		std::cout << "Budget-cells swept: " << scaled_cells << " instead of " << exact_cells << " (budget-cell reduction " << (double)exact_cells / scaled_cells << "x, not a measured time ratio)" << std::endl;
+	}
+
+	//Stop timer
+	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+
+	//Print solution
+	std::cout << "Optimal solution = " << optimal_profit << std::endl;
+	std::cout << "[ ";
+	for (int i = 0; i < Data::n - 1; i++)
+	{
+		if (solution[i]) std::cout << " 1 ,";
+		else std::cout << " 0 ,";
+	}
+	if (!solution[Data::n - 1]) std::cout << " 0 ]" << std::endl;
+	else std::cout << " 1 ]" << std::endl;
+
+	//Write results to file
+	return Write_output(filename, optimal_profit, std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1).count(), solution);
 }
\ No newline at end of file
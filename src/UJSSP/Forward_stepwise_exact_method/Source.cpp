@@ -1,5 +1,12 @@
 ﻿#include "Data.h"
+#include "Stepwise_engine.h"
+#include "Incumbent.h"
+#include "Float_mode.h"
+#include "Deadline.h"
+#include "Incremental.h"
 #include<algorithm>
+#include<cstdlib>
+#include<string>
 #include<iostream>
 #include<fstream>
 #include<vector>
@@ -7,261 +14,183 @@
 #include <cmath>
 
 #define PRINT_INFO false
-#define SPEEDUPS true
+
+//Solve, then apply the edits in the file edits_filename and solve again at every line "solve", starting from the snapshot
+//of the previous solve before the first changed job. Edits are "add r c p", "remove position" and "modify position r c p",
+//with the position of a job in the current ratio order. Snapshots are taken every interval steps, or 32 times per solve if 0.
+int Solve_with_edits(const char* edits_filename, int interval, Thread_pool& thread_pool)
+{
+	std::ifstream edits(edits_filename);
+	if (!edits)
+	{
+		std::cerr << "Could not open edits: " << edits_filename << std::endl;
+		return 1;
+	}
+	Incremental_forward solver(interval > 0 ? interval : Data::n / 32, &thread_pool);
+	std::string command = "solve";
+	do
+	{
+		int position = 0;
+		int r, c;
+		double p;
+		if (command == "solve")
+		{
+			std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+			std::vector<bool> selection;
+			double profit = solver.Solve(selection);
+			std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+			std::cout << "Jobs: " << Data::n << "\t profit: " << profit << "\t resumed after job " << solver.resumed_step
+				<< "\t time: " << std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1).count() << " s\t sets considered: " << solver.nr_sets << std::endl;
+		}
+		else if (command == "add" && edits >> r >> c >> p)
+		{
+			solver.Add_job(r, c, p);
+		}
+		else if (command == "remove" && edits >> position && position >= 0 && position < Data::n)
+		{
+			solver.Remove_job(position);
+		}
+		else if (command == "modify" && edits >> position >> r >> c >> p && position >= 0 && position < Data::n)
+		{
+			solver.Modify_job(position, r, c, p);
+		}
+		else
+		{
+			std::cerr << "Invalid edit: " << command << " " << position << std::endl;
+			return 1;
+		}
+	} while (edits >> command);
+	return 0;
+}
 
 int main(int argc, char* argv[])
 {
-	if (argc != 2)
+	//Read options
+	int nr_threads = 1; //Number of threads that step hulls of at least PARALLEL_HULL_LINES lines
+	bool benchmark = false; //Only time the candidate generation kernels
+	double time_limit = 0; //Seconds after which the best selection found so far is reported, no limit if 0
+	double epsilon = 0; //Approximate mode: the profit found is at least (1 - epsilon) times the optimum, exact if 0
+	const char* edits = nullptr; //Edits of the jobs to solve again after (see Solve_with_edits)
+	int snapshot_interval = 0;
+	const char* filename = nullptr;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--threads" && i + 1 < argc)
+		{
+			nr_threads = std::atoi(argv[++i]);
+		}
+		else if (arg == "--time-limit" && i + 1 < argc)
+		{
+			time_limit = std::atof(argv[++i]);
+		}
+		else if (arg == "--edits" && i + 1 < argc)
+		{
+			edits = argv[++i];
+		}
+		else if (arg == "--snapshot-every" && i + 1 < argc)
+		{
+			snapshot_interval = std::atoi(argv[++i]);
+		}
+		else if (arg == "--epsilon" && i + 1 < argc)
+		{
+			epsilon = std::atof(argv[++i]);
+		}
+		else if (arg == "--benchmark")
+		{
+			benchmark = true;
+		}
+		else if (filename == nullptr)
+		{
+			filename = argv[i];
+		}
+		else
+		{
+			filename = nullptr;
+			break;
+		}
+	}
+	if (filename == nullptr)
 	{
-		std::cout << "Usage: " << argv[0] << " < filename > " << std::endl;
+		std::cout << "Usage: " << argv[0] << " [--threads N] [--time-limit S] [--epsilon E] [--edits F [--snapshot-every M]] [--benchmark] < filename > " << std::endl;
 		return 0;
 	}
 
-	Data::ReadData(argv[1]);
+	Data::ReadData(filename);
 	Data::SortData();
 	Data::Print_Data();
+	Thread_pool thread_pool(nr_threads);
+	thread_pool.Run([](int, int) { Flush_denormals(); });
+	if (benchmark)
+	{
+		Extend_kernel::Benchmark();
+		return 0;
+	}
+	if (edits != nullptr)
+	{
+		return Solve_with_edits(edits, snapshot_interval, thread_pool);
+	}
 	
 	//Start timer
 	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
 
 	//Initialize values
-	double ub_R = 0;
-	double prob = 1.0;
-	for (int i = 0; i < Data::n; i++)
-	{
-		prob *= Data::p[i];
-		ub_R += Data::r[i] * prob;
-	}
-	
-	double lb_R = 0;
+	std::vector<double> upper_R = Stepwise_bounds::Upper_R();
+
+	//Profit of a heuristic selection, the hull must reach it at the revenue R of the optimal selection
+	std::vector<bool> incumbent_set;
+	double incumbent = Stepwise_incumbent::Solve(incumbent_set);
+	Forward_engine engine(upper_R, Stepwise_bounds::Target(incumbent), &thread_pool);
+	engine.loss_budget = epsilon * std::max(incumbent, 0.0); //The optimum is at least the incumbent
+	Set_tree& tree = engine.tree;
+	Hull& hull = engine.hull;
 
 #if PRINT_INFO
-	std::cout << "\nUpper Bound R: " << ub_R << std::endl;
-	std::cout << "Lower Bound R: " << lb_R << std::endl;
+	std::cout << "\nUpper Bound R: " << engine.ub_R << std::endl;
+	std::cout << "Lower Bound R: " << engine.lb_R << std::endl;
+	std::cout << "Incumbent: " << incumbent << std::endl;
 #endif
 
-	std::vector<std::vector<bool>> sets;
-	std::vector<double> intercept;
-	std::vector<double> slope;
-	std::vector<double> optimality_limit;
-
-	std::vector<bool> empty(Data::n, false);
-	sets.push_back(empty);
-	intercept.push_back(0.0);
-	slope.push_back(1.0);
-	optimality_limit.push_back(std::numeric_limits<double>::max());
 
-
-	//Algorithm
-	int nr_sets = 1;
+	//Algorithm, stopped between two steps once the time limit has passed
+	Deadline deadline(time_limit);
+	bool time_limit_reached = false;
 	for (int j = 0; j < Data::n; j++)
 	{
-
-		//Add extra subsets
-		std::vector<std::vector<bool>> new_sets;
-		std::vector<double> new_intercept;
-		std::vector<double> new_slope;
-		for (int s = 0; s < sets.size(); s++)
+		if (deadline.Passed(hull.size()))
 		{
-			nr_sets++;
-
-#if SPEEDUPS
-			if (optimality_limit[s] < Data::p[j]*Data::r[j])
-			{
-				continue; //Never optimal to add this job, as revenue will be too high
-			}
-#endif
-
-			std::vector<bool> new_set = sets[s];
-			new_set[j] = true;
-			new_sets.push_back(new_set);
-			new_intercept.push_back(intercept[s] + slope[s] * Data::r[j] * Data::p[j] - Data::c[j]);
-			new_slope.push_back(slope[s] * Data::p[j]);
-			nr_sets++;
-		}
-
-		//Update upperbound
-		ub_R = 0;
-		prob = 1.0;
-		for (int i = j + 1; i < Data::n; i++)
-		{
-			prob *= Data::p[i];
-			ub_R += Data::r[i] * prob;
+			time_limit_reached = true;
+			break;
 		}
-		//ub_R = ub_R / Data::p[j] - Data::r[j];
+		engine.Step(j);
 
 #if PRINT_INFO
 		std::cout << "\n\nSTEP " << j << std::endl;
 		std::cout << "\n\nNew sets:\n" << std::endl;
-		for (int s = 0; s < new_sets.size(); s++)
+		for (int s = 0; s < engine.new_sets.size(); s++)
 		{
+			std::vector<bool> new_set = tree.Materialize(engine.new_sets[s].set, Data::n);
 			std::cout << "[";
 			for (int i = 0; i < Data::n - 1; i++)
 			{
-				std::cout << new_sets[s][i] << ",";
+				std::cout << new_set[i] << ",";
 			}
-			std::cout << new_sets[s][Data::n - 1] << "]\t intercept: " << new_intercept[s] << "\t slope: " << new_slope[s] << std::endl;
+			std::cout << new_set[Data::n - 1] << "]\t intercept: " << engine.new_sets[s].intercept << "\t slope: " << engine.new_sets[s].slope << std::endl;
 			std::cout << std::endl;
 		}
-		std::cout << "Upper Bound R: " << ub_R << std::endl;
-		std::cout << "Lower Bound R: " << lb_R << std::endl;
-#endif
-
-		//Eliminate dominated subsets based on upperbound 
-		bool dominated = true;
-		while (dominated && sets.size() >= 2)
-		{
-			if (optimality_limit[sets.size() - 2] > ub_R)
-			{
-				sets.erase(sets.begin() + sets.size() - 1);
-				intercept.erase(intercept.begin() + intercept.size() - 1);
-				slope.erase(slope.begin() + slope.size() - 1);
-				optimality_limit.erase(optimality_limit.begin() + optimality_limit.size() - 1);
-			}
-			else
-			{
-				dominated = false;
-			}
-		}
-
-		//Consider new sets
-		for (int s = 0; s < new_sets.size(); s++)
-		{
-			// Search for biggest existing slope for which the new slope ≤ existing_slope
-			auto lower = std::lower_bound(slope.begin(), slope.end(), new_slope[s]);
-			int idx_r = std::distance(slope.begin(), lower);
-			int idx_l = idx_r - 1;
-			if (idx_r != slope.size()) 
-			{
-				if (slope[idx_r] == new_slope[s]) //In case of equal slopes: keep the one with the highest intercept
-				{
-					if (intercept[idx_r] >= new_intercept[s])
-					{
-						continue;
-					}
-					else
-					{
-						idx_r += 1;
-					}
-				}
-			}
-			
-
-			double x_r;
-			double x_l;
-			if (idx_r == slope.size())
-			{
-				x_r = std::numeric_limits<double>::max();
-			}
-			else
-			{
-				x_r = (new_intercept[s] - intercept[idx_r]) / (slope[idx_r] - new_slope[s]);
-			}
-			if (idx_l == -1)
-			{
-				x_l = std::numeric_limits<double>::lowest();
-			}
-			else
-			{
-				x_l = (intercept[idx_l] - new_intercept[s]) / (new_slope[s] - slope[idx_l]);
-			}
-
-			if (x_r <= x_l)
-			{
-				continue; // new subset is dominated
-			}
-			if (idx_l == -1 && x_r <= lb_R)
-			{
-				continue; //new subset is dominated
-			}
-			if (idx_r == sets.size() && x_l >= ub_R)
-			{
-				continue; //new subset is dominated
-			}
-
-			//Find smallest index for which the intersection is the highest
-			while (idx_l >= 1)
-			{
-				double new_x_l = (intercept[idx_l - 1] - new_intercept[s]) / (new_slope[s] - slope[idx_l - 1]);
-				if (new_x_l >= x_l)
-				{
-					x_l = new_x_l;
-					idx_l -= 1;
-				}
-				else
-				{
-					break;
-				}
-			}
-
-			//Find largest index for which the intersection is the lowest
-			while (idx_r <= (static_cast<int>(slope.size()) - 2))
-			{
-				double new_x_r = (new_intercept[s] - intercept[idx_r + 1]) / (slope[idx_r + 1] - new_slope[s]);
-				if (new_x_r <= x_r)
-				{
-					x_r = new_x_r;
-					idx_r += 1;
-				}
-				else
-				{
-					break;
-				}
-			}
-
-			//Remove dominated subsets
-			if (idx_r - idx_l > 1)
-			{
-				sets.erase(sets.begin() + (idx_l + 1), sets.begin() + idx_r);
-				intercept.erase(intercept.begin() + (idx_l + 1), intercept.begin() + idx_r);
-				slope.erase(slope.begin() + (idx_l + 1), slope.begin() + idx_r);
-				optimality_limit.erase(optimality_limit.begin() + (idx_l + 1), optimality_limit.begin() + idx_r);
-				idx_r -= (idx_r - idx_l - 1);
-			}
-			if (idx_l == 0 && x_l <= lb_R)
-			{
-				sets.erase(sets.begin());
-				intercept.erase(intercept.begin());
-				slope.erase(slope.begin());
-				optimality_limit.erase(optimality_limit.begin());
-				idx_l = -1;
-				idx_r -= 1;
-			}
-			if (idx_r == sets.size() - 1 && x_r >= ub_R)
-			{
-				sets.erase(sets.begin() + sets.size() - 1);
-				intercept.erase(intercept.begin() + intercept.size() - 1);
-				slope.erase(slope.begin() + slope.size() - 1);
-				optimality_limit.erase(optimality_limit.begin() + optimality_limit.size() - 1);
-			}
-			if (idx_r == sets.size())
-			{
-				x_r = std::numeric_limits<double>::max();
-			}
-			
-
-			//Add new subset
-			sets.insert(sets.begin() + (idx_l + 1), new_sets[s]);
-			intercept.insert(intercept.begin() + (idx_l + 1), new_intercept[s]);
-			slope.insert(slope.begin() + (idx_l + 1), new_slope[s]);
-			optimality_limit.insert(optimality_limit.begin() + (idx_l + 1), x_r);
-			if (idx_l >= 0)
-			{
-				optimality_limit[idx_l] = x_l;
-			}
-
-		}
+		std::cout << "Upper Bound R: " << engine.ub_R << std::endl;
+		std::cout << "Lower Bound R: " << engine.lb_R << std::endl;
 
-#if PRINT_INFO
 		std::cout << "\nOptimal sets after step " << j << ":\n" << std::endl;
-		for (int s = 0; s < sets.size(); s++)
+		for (int s = 0; s < hull.size(); s++)
 		{
+			std::vector<bool> set = tree.Materialize(hull[s].set, Data::n);
 			std::cout << "[";
 			for (int i = 0; i < Data::n - 1; i++)
 			{
-				std::cout << sets[s][i] << ",";
+				std::cout << set[i] << ",";
 			}
-			std::cout << sets[s][Data::n - 1] << "]\t intercept: " << intercept[s] << "\t slope: " << slope[s] << "\t optimal up to: " << optimality_limit[s] << std::endl;
+			std::cout << set[Data::n - 1] << "]\t intercept: " << hull[s].intercept << "\t slope: " << hull[s].slope << "\t optimal up to: " << hull[s].limit << std::endl;
 			std::cout << std::endl;
 		}
 #endif
@@ -270,21 +199,63 @@ int main(int argc, char* argv[])
 	//End timer
 	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
 
-	std::cout << "\nOptimal set:\n" << std::endl;
-	for (int s = 0; s < sets.size(); s++)
+	//Best selection: the optimum, or on a time limit the better of the incumbent and the selections read from the hull, with an upper bound.
+	//In the approximate mode the hull can end below the incumbent, and the optimum is at most the best selection plus engine.lowered.
+	double profit = hull[0].intercept;
+	std::vector<bool> solution;
+	double bound = 0;
+	if (time_limit_reached)
 	{
+		solution = engine.Best_selection();
+		profit = Stepwise_incumbent::Profit(solution);
+		if (profit < incumbent)
+		{
+			solution = incumbent_set;
+			profit = incumbent;
+		}
+		bound = engine.Upper_bound(profit);
+		std::cout << "Time limit reached. Stopping algorithm." << std::endl;
+		std::cout << "\nBest set found:\n" << std::endl;
 		std::cout << "[";
 		for (int i = 0; i < Data::n - 1; i++)
 		{
-			std::cout << sets[s][i] << ",";
+			std::cout << solution[i] << ",";
 		}
-		std::cout << sets[s][Data::n - 1] << "]\t with objective value: " << intercept[s] << std::endl;
-		std::cout << "Number of sets considered: " << nr_sets << " out of " << (std::pow(2, Data::n)) << std::endl;
+		std::cout << solution[Data::n - 1] << "]\t with objective value: " << profit << std::endl;
+		std::cout << "Upper bound: " << bound << " (gap " << (bound - profit) / profit << ")" << std::endl;
+		std::cout << "Number of sets considered: " << engine.nr_sets << " out of " << (std::pow(2, Data::n)) << std::endl;
 		std::cout << std::endl;
 	}
+	else
+	{
+		solution = tree.Materialize(hull[0].set, Data::n);
+		if (epsilon > 0 && profit < incumbent)
+		{
+			solution = incumbent_set;
+			profit = incumbent;
+		}
+		bound = profit + engine.lowered;
+		if (epsilon > 0)
+		{
+			std::cout << "\nApproximate mode: profit " << profit << ", upper bound " << bound << " (achieved epsilon " << (bound - profit) / profit << ")" << std::endl;
+		}
+		std::cout << "\nOptimal set:\n" << std::endl;
+		for (int s = 0; s < hull.size(); s++)
+		{
+			std::vector<bool> set = tree.Materialize(hull[s].set, Data::n);
+			std::cout << "[";
+			for (int i = 0; i < Data::n - 1; i++)
+			{
+				std::cout << set[i] << ",";
+			}
+			std::cout << set[Data::n - 1] << "]\t with objective value: " << hull[s].intercept << std::endl;
+			std::cout << "Number of sets considered: " << engine.nr_sets << " out of " << (std::pow(2, Data::n)) << std::endl;
+			std::cout << std::endl;
+		}
+	}
 
 	//Write results to file
-	std::string inputFilename = argv[1];
+	std::string inputFilename = filename;
 	std::string baseFilename;
 	std::string outputFilename;
 
@@ -323,12 +294,25 @@ int main(int argc, char* argv[])
 	}
 
 	// Write to output file
-	outFile << intercept[0] << std::endl;
+	outFile << profit << std::endl;
 	outFile << std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1).count() << std::endl;
 	outFile << Data::n << std::endl;
-	outFile << nr_sets << std::endl;
+	outFile << engine.nr_sets << std::endl;
 	for (int i = 0; i < Data::n; i++)
 	{
-		outFile << sets[0][i] << "\t" << Data::r[i] << "\t" << Data::c[i] << "\t" << Data::p[i] << std::endl;
+		outFile << solution[i] << "\t" << Data::r[i] << "\t" << Data::c[i] << "\t" << Data::p[i] << std::endl;
+	}
+	if (time_limit_reached || epsilon > 0)
+	{
+		//Upper bound and gap of the best selection, as (bound - profit) / profit
+		outFile << bound << std::endl;
+		outFile << (bound - profit) / profit << std::endl;
+	}
+
+	//Write the counters of every step next to the output file
+	std::string traceFilename = Trace_filename(outputFilename);
+	if (!Write_trace(traceFilename, { &engine.trace }, "F")) {
+		std::cerr << "Could not write trace: " << traceFilename << std::endl;
+		return 1;
 	}
 }
\ No newline at end of file
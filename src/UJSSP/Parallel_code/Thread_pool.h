@@ -0,0 +1,112 @@
+#pragma once
+#include<algorithm>
+#include<atomic>
+#include<condition_variable>
+#include<functional>
+#include<mutex>
+#include<thread>
+#include<vector>
+
+//Persistent pool of threads that all run the same task, used to split the work of one step over several cores
+//The calling thread takes part as thread 0, so a pool of size 1 runs everything on the calling thread
+class Thread_pool
+{
+public:
+	Thread_pool(int nr_threads)
+	{
+		size = std::max(1, nr_threads);
+		for (int t = 1; t < size; t++)
+		{
+			workers.emplace_back([this, t]() { Work(t); });
+		}
+	}
+
+	~Thread_pool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+			generation++;
+		}
+		start.notify_all();
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	int Size() const
+	{
+		return size;
+	}
+
+	//Run task(thread, nr_threads) on every thread of the pool and wait until all of them are done, which acts as a barrier
+	void Run(const std::function<void(int, int)>& new_task)
+	{
+		if (size == 1)
+		{
+			new_task(0, 1);
+			return;
+		}
+		task = &new_task;
+		pending.store(size - 1);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			generation++;
+		}
+		start.notify_all();
+		new_task(0, size);
+
+		//Wait for the other threads, spin shortly before going to sleep
+		for (int spin = 0; spin < spin_limit && pending.load() != 0; spin++)
+		{
+			std::this_thread::yield();
+		}
+		if (pending.load() != 0)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			done.wait(lock, [this]() { return pending.load() == 0; });
+		}
+	}
+
+private:
+	static const int spin_limit = 2000;
+
+	int size;
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable start;
+	std::condition_variable done;
+	std::atomic<int> generation{ 0 };
+	std::atomic<int> pending{ 0 };
+	const std::function<void(int, int)>* task = nullptr;
+	bool stop = false;
+
+	void Work(int thread)
+	{
+		int seen = 0;
+		while (true)
+		{
+			//Wait for a new task, spin shortly before going to sleep
+			for (int spin = 0; spin < spin_limit && generation.load() == seen; spin++)
+			{
+				std::this_thread::yield();
+			}
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				start.wait(lock, [this, seen]() { return generation.load() != seen; });
+				if (stop)
+				{
+					return;
+				}
+				seen = generation.load();
+			}
+			(*task)(thread, size);
+			if (pending.fetch_sub(1) == 1)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				done.notify_one();
+			}
+		}
+	}
+};
@@ -0,0 +1,278 @@
+#include "Data.h"
+#include<iostream>
+#include<fstream>
+#include<vector>
+#include<chrono>
+#include<string>
+#include<algorithm>
+#include<cmath>
+#include<new>
+
+//Non-dominated state of a job suffix: total cost and expected revenue
+struct State
+{
+	int cost;
+	double revenue;
+};
+
+//Revenue and joint probability of all jobs before job n, used to prune states that can not beat the incumbent
+std::vector<double> prefix_revenue;
+std::vector<double> prefix_prob;
+
+//Dynamic programming step of job n: merge the states without job n with the states that add job n (both sorted by cost) into new_states,
+//keeping the states below max_budget that are not dominated and can still beat the incumbent, which is raised by the new states.
+//If costs is given, it receives the cost of every new state and took whether that state adds job n, to backtrack the solution:
+//a state of cost C adding job n comes from the state of cost C - c_n of the states of job n + 1, otherwise from the state of cost C.
+void Step(int n, const std::vector<State>& states, std::vector<State>& new_states, double& incumbent, double max_budget, std::vector<int>* costs, std::vector<bool>* took)
+{
+	new_states.clear();
+	size_t i = 0;
+	size_t k = 0;
+	while (i < states.size() || k < states.size())
+	{
+		State next;
+		bool added = false;
+		if (k < states.size() && states[k].cost + Data::c[n] <= max_budget
+			&& (i == states.size() || states[k].cost + Data::c[n] < states[i].cost))
+		{
+			next = { states[k].cost + Data::c[n], Data::p[n] * (Data::r[n] + states[k].revenue) };
+			added = true;
+			k++;
+		}
+		else if (i < states.size())
+		{
+			next = states[i];
+			i++;
+		}
+		else
+		{
+			break; //Remaining states with job n exceed the budget bound
+		}
+
+		//Keep only states with a strictly higher revenue than all cheaper states
+		if (!new_states.empty() && next.revenue <= new_states.back().revenue)
+		{
+			continue;
+		}
+		//Prune states that can not beat the best profit found so far
+		if (prefix_revenue[n] + prefix_prob[n] * next.revenue - next.cost < incumbent - 1e-9 * std::abs(incumbent))
+		{
+			continue;
+		}
+		//A state with the same cost but lower revenue is dominated
+		while (!new_states.empty() && new_states.back().cost == next.cost)
+		{
+			new_states.pop_back();
+			if (costs != nullptr)
+			{
+				costs->pop_back();
+				took->pop_back();
+			}
+		}
+		new_states.push_back(next);
+		if (costs != nullptr)
+		{
+			costs->push_back(next.cost);
+			took->push_back(added);
+		}
+		incumbent = std::max(incumbent, next.revenue - next.cost);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 2)
+	{
+		std::cout << "Usage: " << argv[0] << " < filename > " << std::endl;
+		return 0;
+	}
+	const char* filename = argv[1];
+
+	Data::ReadData(filename);
+	Data::SortData();
+	Data::Print_Data();
+
+	//Start timer
+	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+
+	//Revenue and joint probability of all jobs before job n: adding a job in ratio order never lowers the revenue,
+	//so prefix_revenue[n] + prefix_prob[n] * R is the highest revenue any selection can reach with a suffix of revenue R
+	prefix_revenue.assign(Data::n + 1, 0.0);
+	prefix_prob.assign(Data::n + 1, 1.0);
+	for (int n = 0; n < Data::n; n++)
+	{
+		prefix_prob[n + 1] = prefix_prob[n] * Data::p[n];
+		prefix_revenue[n + 1] = prefix_revenue[n] + prefix_prob[n + 1] * Data::r[n];
+	}
+
+	//Upper bound on the optimal budget and greedy lower bound on the optimal profit, as in the dense dynamic programming
+	double max_revenue = 0;
+	double greedy_revenue = 0;
+	double greedy_cost = 0;
+	for (int n = Data::n - 1; n >= 0; n--)
+	{
+		max_revenue = Data::p[n] * (Data::r[n] + max_revenue);
+		double including = Data::p[n] * (Data::r[n] + greedy_revenue);
+		if (including - Data::c[n] > greedy_revenue)
+		{
+			greedy_revenue = including;
+			greedy_cost += Data::c[n];
+		}
+	}
+	double incumbent = greedy_revenue - greedy_cost;
+	double max_budget = std::floor(max_revenue - incumbent) + 1;
+
+	//Dynamic programming over the lists of non-dominated (cost, revenue) states, sorted by increasing cost and revenue.
+	//The jobs are split in segments. Only the states at the start of every segment are kept (checkpoints, with the incumbent
+	//at that moment so that a segment can be repeated exactly), plus the costs and decisions of the states of the last segment.
+	//The decisions of the other segments are recomputed from their checkpoint while backtracking, which costs at most one extra pass,
+	//so the memory grows with the number of states alive instead of with all states ever created.
+	//Segments of sqrt(n) jobs: the states grow towards job 0, so longer segments make the decisions of the last segment the largest part.
+	int segment_length = std::max(1, (int)std::sqrt((double)Data::n));
+	int nr_segments = (Data::n + segment_length - 1) / segment_length;
+	std::vector<std::vector<State>> checkpoints(nr_segments); //Checkpoint s holds the states of the jobs after segment s
+	std::vector<double> checkpoint_incumbent(nr_segments);
+	std::vector<std::vector<int>> costs(segment_length); //Costs of the states of job first_job + l of the current segment
+	std::vector<std::vector<bool>> took(segment_length); //Whether those states add their job
+	std::vector<State> states(1, { 0, 0.0 });
+	std::vector<State> new_states;
+	long long nr_states = 1;
+	size_t max_nr_states = 1;
+	std::vector<bool> solution(Data::n, false);
+	double optimal_profit = 0;
+	try
+	{
+		for (int n = Data::n - 1; n >= 0; n--)
+		{
+			int segment = n / segment_length;
+			if (n == std::min(Data::n, (segment + 1) * segment_length) - 1)
+			{
+				checkpoints[segment] = states;
+				checkpoint_incumbent[segment] = incumbent;
+			}
+			int l = n - segment * segment_length;
+			if (segment == 0)
+			{
+				costs[l].clear();
+				took[l].clear();
+			}
+			Step(n, states, new_states, incumbent, max_budget, segment == 0 ? &costs[l] : nullptr, segment == 0 ? &took[l] : nullptr);
+			std::swap(states, new_states);
+			nr_states += states.size();
+			max_nr_states = std::max(max_nr_states, states.size());
+		}
+
+		//Find optimal solution among the final states
+		int cost = 0;
+		for (const State& state : states)
+		{
+			if (state.revenue - state.cost > optimal_profit)
+			{
+				optimal_profit = state.revenue - state.cost;
+				cost = state.cost;
+			}
+		}
+
+		//Backtrack the optimal solution from job 0 on, repeating every segment after the first from its checkpoint
+		for (int segment = 0; segment < nr_segments; segment++)
+		{
+			int first_job = segment * segment_length;
+			int last_job = std::min(Data::n, first_job + segment_length) - 1;
+			if (segment > 0)
+			{
+				states = checkpoints[segment];
+				double segment_incumbent = checkpoint_incumbent[segment];
+				for (int n = last_job; n >= first_job; n--)
+				{
+					int l = n - first_job;
+					costs[l].clear();
+					took[l].clear();
+					Step(n, states, new_states, segment_incumbent, max_budget, &costs[l], &took[l]);
+					std::swap(states, new_states);
+				}
+			}
+			checkpoints[segment].clear();
+			checkpoints[segment].shrink_to_fit();
+			for (int n = first_job; n <= last_job; n++)
+			{
+				int l = n - first_job;
+				size_t s = std::lower_bound(costs[l].begin(), costs[l].end(), cost) - costs[l].begin();
+				if (s < costs[l].size() && costs[l][s] == cost && took[l][s])
+				{
+					solution[n] = true;
+					cost -= Data::c[n];
+				}
+			}
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		std::cerr << "Out of memory with " << states.size() << " states alive after " << nr_states << " states in total." << std::endl;
+		return 1;
+	}
+
+	//Stop timer
+	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+
+	//Print solution
+	std::cout << "Optimal solution = " << optimal_profit << std::endl;
+	std::cout << "Number of states: " << nr_states << " in total, at most " << max_nr_states << " per job" << std::endl;
+	std::cout << "[ ";
+	for (int i = 0; i < Data::n - 1; i++)
+	{
+		if (solution[i]) std::cout << " 1 ,";
+		else std::cout << " 0 ,";
+	}
+	if (!solution[Data::n - 1]) std::cout << " 0 ]" << std::endl;
+	else std::cout << " 1 ]" << std::endl;
+
+	//Write results to file
+	std::string inputFilename = filename;
+	std::string baseFilename;
+	std::string outputFilename;
+
+	// Check if it ends with ".dat"
+	if (inputFilename.size() >= 4 && inputFilename.substr(inputFilename.size() - 4) == ".dat") {
+		// Strip .dat extension
+		baseFilename = inputFilename.substr(0, inputFilename.size() - 4);
+	}
+	else {
+		std::cerr << "Input file does not have a .dat extension." << std::endl;
+		return 1;
+	}
+
+	// Find last slash
+	size_t lastSlash = baseFilename.find_last_of("/");
+
+	if (lastSlash != std::string::npos) {
+		// There is a directory in the path
+		std::string folder = baseFilename.substr(0, lastSlash);
+		std::string filenameOnly = baseFilename.substr(lastSlash + 1);
+
+		// Go one level up from folder and then into "output/"
+		outputFilename = folder + "/output/" + filenameOnly + ".out";
+	}
+	else {
+		// No slashes, just replace .dat with .out
+		outputFilename = baseFilename + ".out";
+	}
+
+
+	// Open output file for writing
+	std::ofstream outFile(outputFilename);
+	if (!outFile) {
+		std::cerr << "Could not open file for writing: " << outputFilename << std::endl;
+		return 1;
+	}
+
+	// Write to output file
+	outFile << optimal_profit << std::endl;
+	outFile << std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1).count() << std::endl;
+	outFile << Data::n << std::endl;
+	for (int i = 0; i < Data::n; i++)
+	{
+		outFile << solution[i] << "\t" << Data::r[i] << "\t" << Data::c[i] << "\t" << Data::p[i] << std::endl;
+	}
+
+	return 0;
+}
\ No newline at end of file
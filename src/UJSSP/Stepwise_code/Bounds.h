@@ -0,0 +1,87 @@
+#pragma once
+#include "Data.h"
+#include<algorithm>
+#include<cmath>
+#include<vector>
+
+//Bounds on the x-axis of the stepwise methods, precomputed once so that every step reads them in O(1).
+//They rest on one property of an optimal selection: removing a selected job t must not raise the profit.
+//With P the probability of the jobs before t and R the revenue of the jobs after t (the part after t weighted by p_t),
+//removing t changes the profit by P * (p_t * r_t - (1 - p_t) * R) - c_t, so an optimal selection needs
+//	p_t * r_t - c_t >= (1 - p_t) * R	and	P * p_t * r_t >= c_t.
+//The bounds are widened by a relative margin so that rounding never removes the optimal line.
+namespace Stepwise_bounds
+{
+	const double margin = 1e-9;
+
+	//Jobs with p_j * r_j < c_j are never part of an optimal selection
+	inline bool Worthwhile(int j)
+	{
+		return Data::p[j] * Data::r[j] >= Data::c[j];
+	}
+
+	//Forward method: upper_R[j] bounds the revenue R of the jobs j..n-1 in an optimal selection.
+	//Either job j is skipped (upper_R[j + 1]), or R = p_j * (r_j + R') with R' <= upper_R[j + 1] and R' <= (p_j * r_j - c_j) / (1 - p_j).
+	//This accounts for the costs of the remaining jobs and is at most the revenue of selecting all of them.
+	inline std::vector<double> Upper_R()
+	{
+		std::vector<double> upper_R(Data::n + 1, 0.0);
+		for (int j = Data::n - 1; j >= 0; j--)
+		{
+			upper_R[j] = upper_R[j + 1];
+			if (Worthwhile(j))
+			{
+				double tail = upper_R[j + 1];
+				if (Data::p[j] < 1.0)
+				{
+					tail = std::min(tail, (Data::p[j] * Data::r[j] - Data::c[j]) / (1.0 - Data::p[j]));
+				}
+				upper_R[j] = std::max(upper_R[j], Data::p[j] * (Data::r[j] + tail));
+			}
+		}
+		for (double& bound : upper_R)
+		{
+			bound *= 1.0 + margin;
+		}
+		return upper_R;
+	}
+
+	//Backward method: lower_P[j] bounds the probability P of the jobs 0..j-1 in an optimal selection from below.
+	//P is at least the product of the probabilities of the worthwhile jobs, and if t is the last selected job before j
+	//then P >= c_t / (p_t * r_t) * p_t = c_t / r_t, while P = 1 if no job before j is selected.
+	inline std::vector<double> Lower_P()
+	{
+		std::vector<double> lower_P(Data::n + 1, 1.0);
+		double product = 1.0;
+		double ratio = 1.0; //Smallest c_t / r_t of the worthwhile jobs so far
+		for (int j = 0; j < Data::n; j++)
+		{
+			lower_P[j] = std::max(product, ratio) * (1.0 - margin);
+			if (Worthwhile(j))
+			{
+				product *= Data::p[j];
+				ratio = std::min(ratio, Data::r[j] > 0 ? (double)Data::c[j] / Data::r[j] : 0.0);
+			}
+		}
+		lower_P[Data::n] = std::max(product, ratio) * (1.0 - margin);
+		return lower_P;
+	}
+
+	//Backward method: gain[j] bounds the profit of the selected jobs 0..j-1 (without the jobs from j on) from above,
+	//as the revenue of a selected job i is at most p_i * r_i
+	inline std::vector<double> Prefix_gain()
+	{
+		std::vector<double> gain(Data::n + 1, 0.0);
+		for (int j = 0; j < Data::n; j++)
+		{
+			gain[j + 1] = gain[j] + std::max(0.0, Data::p[j] * Data::r[j] - Data::c[j]);
+		}
+		return gain;
+	}
+
+	//Incumbent profit lowered by the margin, so that lines reaching an optimum equal to the incumbent are kept
+	inline double Target(double incumbent)
+	{
+		return incumbent - margin * (std::abs(incumbent) + 1.0);
+	}
+}
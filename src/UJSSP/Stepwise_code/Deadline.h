@@ -0,0 +1,40 @@
+#pragma once
+#include<chrono>
+#include<cstddef>
+
+#ifndef CLOCK_CHECK_LINES
+#define CLOCK_CHECK_LINES 65536
+#endif
+
+//Time limit of the anytime mode of the stepwise methods. The clock is only read once the steps since the last read
+//handled at least CLOCK_CHECK_LINES hull lines, so the check costs nothing next to the steps themselves.
+class Deadline
+{
+public:
+	//No limit if seconds <= 0
+	Deadline(double seconds) : limited(seconds > 0)
+	{
+		end = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(limited ? seconds : 0.0));
+	}
+
+	//Whether the time limit has passed, counting lines more hull lines of work since the last call
+	bool Passed(size_t lines)
+	{
+		if (!limited)
+		{
+			return false;
+		}
+		work += lines;
+		if (work < CLOCK_CHECK_LINES)
+		{
+			return false;
+		}
+		work = 0;
+		return std::chrono::steady_clock::now() >= end;
+	}
+
+private:
+	bool limited;
+	size_t work = 0;
+	std::chrono::steady_clock::time_point end;
+};
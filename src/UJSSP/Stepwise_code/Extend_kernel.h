@@ -0,0 +1,148 @@
+#pragma once
+#include "Data.h"
+#include "Set_tree.h"
+#include "Hull.h"
+#include<chrono>
+#include<cstddef>
+#include<iostream>
+#include<random>
+#include<vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define EXTEND_SSE2 true
+#include<emmintrin.h>
+#else
+#define EXTEND_SSE2 false
+#endif
+
+//Candidate generation of the stepwise engines: out[i] is the line in[i] with job j added, its subset gets handle base + i
+//and the node of that handle is written to the tree. The candidates of a step are always a contiguous range of the hull
+//(the SPEEDUPS cut is a binary search), so no mask or compaction is needed and out can be a preallocated buffer.
+//Intercept and slope are adjacent in a Line, so one SSE2 register holds both and a line takes two multiplies and two adds
+//(forward) or one of each (backward). The operations are the ones of the scalar formulas in the same order, without
+//fused multiply-adds, so the lines are bit-identical to the scalar loop.
+namespace Extend_kernel
+{
+	//Forward method: intercept + slope * r_j * p_j - c_j and slope * p_j
+	inline void Forward(const Line* in, size_t count, int j, int base, Line* out, Set_tree& tree)
+	{
+		double p = Data::p[j];
+		double r = Data::r[j];
+		double c = Data::c[j];
+#if EXTEND_SSE2
+		__m128d factor_r = _mm_set_pd(1.0, r); //[r, 1]
+		__m128d factor_p = _mm_set1_pd(p);
+		__m128d cost = _mm_set_pd(0.0, c);
+		for (size_t i = 0; i < count; i++)
+		{
+			__m128d line = _mm_loadu_pd(&in[i].intercept); //[intercept, slope]
+			__m128d slope = _mm_unpackhi_pd(line, line);
+			__m128d gain = _mm_mul_pd(_mm_mul_pd(slope, factor_r), factor_p); //[slope * r * p, slope * p]
+			__m128d intercept = _mm_move_sd(_mm_setzero_pd(), line); //[intercept, 0]
+			_mm_storeu_pd(&out[i].intercept, _mm_sub_pd(_mm_add_pd(intercept, gain), cost));
+			out[i].limit = 0.0;
+			out[i].set = base + (int)i;
+			tree.Set(base + (int)i, in[i].set, j);
+		}
+#else
+		for (size_t i = 0; i < count; i++)
+		{
+			out[i] = { in[i].intercept + in[i].slope * r * p - c, in[i].slope * p, 0.0, base + (int)i };
+			tree.Set(base + (int)i, in[i].set, j);
+		}
+#endif
+	}
+
+	//Backward method: intercept - c_j and p_j * r_j + p_j * slope
+	inline void Backward(const Line* in, size_t count, int j, int base, Line* out, Set_tree& tree)
+	{
+		double p = Data::p[j];
+		double r = Data::r[j];
+		double c = Data::c[j];
+#if EXTEND_SSE2
+		__m128d factor = _mm_set_pd(p, 1.0); //[1, p]
+		__m128d term = _mm_set_pd(p * r, -c);
+		for (size_t i = 0; i < count; i++)
+		{
+			__m128d line = _mm_loadu_pd(&in[i].intercept); //[intercept, slope]
+			_mm_storeu_pd(&out[i].intercept, _mm_add_pd(_mm_mul_pd(line, factor), term));
+			out[i].limit = 0.0;
+			out[i].set = base + (int)i;
+			tree.Set(base + (int)i, in[i].set, j);
+		}
+#else
+		for (size_t i = 0; i < count; i++)
+		{
+			out[i] = { in[i].intercept - c, p * r + p * in[i].slope, 0.0, base + (int)i };
+			tree.Set(base + (int)i, in[i].set, j);
+		}
+#endif
+	}
+
+	//Time the candidate generation of one step over hulls of 10^3 to 10^6 lines: the loop of push_back calls the engines used
+	//before against the kernels, in lines per second. Uses job 0 of the data read.
+	inline void Benchmark()
+	{
+		std::mt19937 gen(1);
+		std::uniform_real_distribution<> dist(0.0, 1.0);
+		int j = 0;
+		for (size_t size = 1000; size <= 1000000; size *= 10)
+		{
+			std::vector<Line> hull(size);
+			for (size_t s = 0; s < size; s++)
+			{
+				hull[s] = { 1000.0 * dist(gen), dist(gen), 0.0, (int)s - 1 };
+			}
+			int repeats = (int)(10000000 / size);
+			std::vector<Line> new_sets;
+			double best[4] = { 1e300, 1e300, 1e300, 1e300 };
+			double check = 0;
+			for (int round = 0; round < 3; round++)
+			{
+				for (int method = 0; method < 4; method++)
+				{
+					double seconds = 0;
+					for (int repeat = 0; repeat < repeats; repeat++)
+					{
+						Set_tree tree;
+						tree.Reserve((int)size); //Parents of the hull
+						std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+						if (method == 0)
+						{
+							new_sets.clear();
+							for (size_t s = 0; s < size; s++)
+							{
+								new_sets.push_back({ hull[s].intercept + hull[s].slope * Data::r[j] * Data::p[j] - Data::c[j], hull[s].slope * Data::p[j], 0.0, tree.Add(hull[s].set, j) });
+							}
+						}
+						else if (method == 1)
+						{
+							new_sets.resize(size);
+							Forward(hull.data(), size, j, tree.Reserve((int)size), new_sets.data(), tree);
+						}
+						else if (method == 2)
+						{
+							new_sets.clear();
+							for (size_t s = 0; s < size; s++)
+							{
+								new_sets.push_back({ hull[s].intercept - Data::c[j], Data::p[j] * Data::r[j] + Data::p[j] * hull[s].slope, 0.0, tree.Add(hull[s].set, j) });
+							}
+						}
+						else
+						{
+							new_sets.resize(size);
+							Backward(hull.data(), size, j, tree.Reserve((int)size), new_sets.data(), tree);
+						}
+						std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+						seconds += std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1).count();
+						check += new_sets[size / 2].intercept;
+					}
+					best[method] = std::min(best[method], seconds);
+				}
+			}
+			double lines = (double)size * repeats;
+			std::cout << "Hull of " << size << " lines: forward " << lines / best[0] / 1e6 << " -> " << lines / best[1] / 1e6
+				<< ", backward " << lines / best[2] / 1e6 << " -> " << lines / best[3] / 1e6 << " million lines per second (push_back loop -> kernel)" << (check == 0 ? " " : "") << std::endl;
+		}
+	}
+}
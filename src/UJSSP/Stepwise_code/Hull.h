@@ -0,0 +1,274 @@
+#pragma once
+#include "Thread_pool.h"
+#include<algorithm>
+#include<atomic>
+#include<limits>
+#include<vector>
+
+//Line of a subset in the stepwise methods: its value at x is intercept + slope * x, and in a hull it is optimal
+//from the limit of the previous line up to limit
+struct Line
+{
+	double intercept;
+	double slope;
+	double limit;
+	int set; //Handle of the subset in the Set_tree
+};
+
+//Upper envelope of lines, sorted by strictly increasing slope, stored as one contiguous array of lines
+//so that a scan over the hull touches every cache line once. The last line is optimal up to the maximal double.
+class Hull
+{
+public:
+	std::vector<Line> lines;
+
+	size_t size() const { return lines.size(); }
+	Line& operator[](size_t s) { return lines[s]; }
+	const Line& operator[](size_t s) const { return lines[s]; }
+
+	//x at which line b (with the larger slope) becomes better than line a
+	static double Intersection(const Line& a, const Line& b)
+	{
+		return (a.intercept - b.intercept) / (b.slope - a.slope);
+	}
+
+	//Index of the first line that is optimal up to at least x, or after x if strict
+	size_t First_limit_from(double x, bool strict) const
+	{
+		if (strict)
+		{
+			return std::upper_bound(lines.begin(), lines.end(), x, [](double value, const Line& line) { return value < line.limit; }) - lines.begin();
+		}
+		return std::lower_bound(lines.begin(), lines.end(), x, [](const Line& line, double value) { return line.limit < value; }) - lines.begin();
+	}
+
+	//Smallest x at which the hull reaches value, or the maximal double if it never does. All slopes must be nonnegative,
+	//so the hull is nondecreasing and its value at the limits of the lines can be binary searched.
+	double First_reaching(double value) const
+	{
+		size_t s = std::partition_point(lines.begin(), lines.end() - 1, [value](const Line& line) { return line.intercept + line.slope * line.limit < value; }) - lines.begin();
+		double start = s > 0 ? lines[s - 1].limit : std::numeric_limits<double>::lowest();
+		if (lines[s].intercept >= value)
+		{
+			return start;
+		}
+		if (lines[s].slope <= 0.0)
+		{
+			return std::numeric_limits<double>::max();
+		}
+		return std::max(start, (value - lines[s].intercept) / lines[s].slope);
+	}
+
+	//Remove the lines that are only optimal below lower or above upper, returns the number of lines removed
+	size_t Clip(double lower, double upper)
+	{
+		size_t size = lines.size();
+		size_t first = 0;
+		while (first + 1 < lines.size() && lines[first].limit <= lower)
+		{
+			first++;
+		}
+		size_t last = lines.size();
+		while (last - first >= 2 && lines[last - 2].limit >= upper)
+		{
+			last--;
+		}
+		lines.erase(lines.begin() + last, lines.end());
+		lines.erase(lines.begin(), lines.begin() + first);
+		lines.back().limit = std::numeric_limits<double>::max();
+		return size - lines.size();
+	}
+
+	//Approximate mode: remove lines that raise the hull by at most tolerance anywhere, keeping the first and the last line.
+	//Greedy from left to right, extending the run of removed lines as long as it stays within tolerance. Every removed line
+	//minus the kept lines prev and next around its run is concave with its kink at their intersection x, so the run lowers
+	//the hull most at x, by the value of the hull there minus prev at x. Returns the largest amount the hull was lowered by.
+	double Prune(double tolerance)
+	{
+		size_t size = lines.size();
+		if (size < 3 || tolerance <= 0)
+		{
+			return 0;
+		}
+		double lowered = 0;
+		Line prev = lines[0];
+		size_t prev_index = 0;
+		size_t kept = 1;
+		for (size_t i = 1; i + 1 < size; i++)
+		{
+			//Lines up to kept - 1 <= prev_index are overwritten, the run prev_index + 1..i is still intact
+			double x = Intersection(prev, lines[i + 1]);
+			size_t s = std::lower_bound(lines.begin() + prev_index + 1, lines.begin() + i + 1, x, [](const Line& line, double value) { return line.limit < value; }) - lines.begin();
+			s = std::min(s, i);
+			double loss = lines[s].intercept + lines[s].slope * x - (prev.intercept + prev.slope * x);
+			if (loss <= tolerance)
+			{
+				lowered = std::max(lowered, loss);
+				continue;
+			}
+			lines[kept - 1].limit = Intersection(lines[kept - 1], lines[i]);
+			prev = lines[i];
+			prev_index = i;
+			lines[kept++] = prev;
+		}
+		lines[kept - 1].limit = Intersection(lines[kept - 1], lines[size - 1]);
+		lines[kept++] = lines[size - 1];
+		lines.resize(kept);
+		return lowered;
+	}
+
+	//Upper envelope of the lines a[0..na) and b[0..nb) (both sorted by strictly increasing slope), written to out with their limits.
+	//Both lists are merged by slope and a stack keeps the lines that are optimal on an interval of positive length,
+	//so this takes linear time. Of two lines with equal slopes the one with the highest intercept is kept, a wins ties.
+	//Returns the number of lines written, equal_slope counts the lines dropped for an equal slope.
+	static size_t Envelope(const Line* a, size_t na, const Line* b, size_t nb, Line* stack, size_t& equal_slope)
+	{
+		size_t top = 0; //Number of lines on the stack
+		size_t i = 0;
+		size_t k = 0;
+		while (i < na || k < nb)
+		{
+			const Line& line = k == nb || (i < na && a[i].slope <= b[k].slope) ? a[i++] : b[k++];
+			if (top > 0 && stack[top - 1].slope == line.slope)
+			{
+				equal_slope++;
+				if (stack[top - 1].intercept >= line.intercept)
+				{
+					continue;
+				}
+				top--;
+			}
+			while (top > 0)
+			{
+				double x = Intersection(stack[top - 1], line);
+				double start = top >= 2 ? stack[top - 2].limit : std::numeric_limits<double>::lowest();
+				if (x > start)
+				{
+					stack[top - 1].limit = x;
+					break;
+				}
+				top--;
+			}
+			stack[top] = line;
+			stack[top].limit = std::numeric_limits<double>::max();
+			top++;
+		}
+		return top;
+	}
+
+	//Replace this hull by the upper envelope of a and b (both sorted by strictly increasing slope) on lower <= x <= upper
+	void Merge(const std::vector<Line>& a, const std::vector<Line>& b, double lower, double upper)
+	{
+		lines.resize(a.size() + b.size());
+		equal_slope = 0;
+		lines.resize(Envelope(a.data(), a.size(), b.data(), b.size(), lines.data(), equal_slope));
+		dominated = a.size() + b.size() - lines.size() - equal_slope;
+		clipped = Clip(lower, upper);
+	}
+
+	//Same as Merge for a and b that are both upper envelopes with their limits set, split over the threads of pool.
+	//The x-axis is cut at the limit of every chunk_lines-th line of a. In every piece only the lines of a and b that are optimal
+	//there (plus one on either side against rounding) are merged and the result is trimmed to the piece, so the pieces are
+	//independent. Joining them only fixes the limit at every cut. The cuts do not depend on the number of threads,
+	//so neither does the result.
+	//The pieces overlap, so equal slopes are not counted by their envelopes: a line is dropped for an equal slope once for every
+	//line of a with a line of the same slope in b (as in Envelope), and every piece counts these pairs for its own chunk of a only.
+	void Merge_chunked(const std::vector<Line>& a, const std::vector<Line>& b, double lower, double upper, Thread_pool& pool, size_t chunk_lines)
+	{
+		size_t nr_chunks = (a.size() + chunk_lines - 1) / chunk_lines;
+		pieces.resize(nr_chunks);
+		auto cut = [&](size_t t) { return t == 0 ? std::numeric_limits<double>::lowest() : t == nr_chunks ? std::numeric_limits<double>::max() : a[t * chunk_lines - 1].limit; };
+		auto first_from = [](const std::vector<Line>& list, double x) { return (size_t)(std::lower_bound(list.begin(), list.end(), x, [](const Line& line, double value) { return line.limit < value; }) - list.begin()); };
+		auto first_after = [](const std::vector<Line>& list, double x) { return (size_t)(std::upper_bound(list.begin(), list.end(), x, [](double value, const Line& line) { return value < line.limit; }) - list.begin()); };
+
+		std::atomic<size_t> next_chunk(0);
+		std::atomic<size_t> total_equal_slope(0);
+		pool.Run([&](int, int)
+			{
+				size_t thread_equal_slope = 0;
+				size_t overlapping = 0; //Equal slopes seen by the envelope of a piece, possibly also by its neighbours
+				for (size_t t = next_chunk.fetch_add(1); t < nr_chunks; t = next_chunk.fetch_add(1))
+				{
+					double from = cut(t);
+					double to = cut(t + 1);
+					size_t a_begin = t * chunk_lines > 0 ? t * chunk_lines - 1 : 0;
+					size_t a_end = std::min(a.size(), (t + 1) * chunk_lines + 1);
+					size_t b_begin = std::min(first_from(b, from), b.size());
+					b_begin = b_begin > 0 ? b_begin - 1 : 0;
+					size_t b_end = std::min(b.size(), first_after(b, to) + 2);
+					std::vector<Line>& piece = pieces[t];
+					piece.resize(a_end - a_begin + b_end - b_begin);
+					piece.resize(Envelope(a.data() + a_begin, a_end - a_begin, b.data() + b_begin, b_end - b_begin, piece.data(), overlapping));
+
+					//Lines of a in this chunk with a line of the same slope in b
+					size_t own_end = std::min(a.size(), (t + 1) * chunk_lines);
+					size_t k = std::lower_bound(b.begin(), b.end(), a[t * chunk_lines].slope, [](const Line& line, double slope) { return line.slope < slope; }) - b.begin();
+					for (size_t i = t * chunk_lines; i < own_end && k < b.size(); i++)
+					{
+						while (k < b.size() && b[k].slope < a[i].slope)
+						{
+							k++;
+						}
+						if (k < b.size() && b[k].slope == a[i].slope)
+						{
+							thread_equal_slope++;
+						}
+					}
+
+					size_t first = 0;
+					while (first + 1 < piece.size() && piece[first].limit <= from)
+					{
+						first++;
+					}
+					size_t last = piece.size();
+					while (last - first >= 2 && piece[last - 2].limit >= to)
+					{
+						last--;
+					}
+					piece.erase(piece.begin() + last, piece.end());
+					piece.erase(piece.begin(), piece.begin() + first);
+				}
+				total_equal_slope.fetch_add(thread_equal_slope);
+			});
+
+		//Join the pieces: a line optimal on both sides of a cut is kept once, otherwise the last line of a piece ends where the next piece starts
+		std::vector<size_t> offset(nr_chunks + 1, 0);
+		for (size_t t = 0; t < nr_chunks; t++)
+		{
+			std::vector<Line>& piece = pieces[t];
+			if (t + 1 < nr_chunks)
+			{
+				const Line& next = pieces[t + 1].front();
+				if (piece.back().set == next.set)
+				{
+					piece.pop_back();
+				}
+				else
+				{
+					piece.back().limit = Intersection(piece.back(), next);
+				}
+			}
+			offset[t + 1] = offset[t] + piece.size();
+		}
+		lines.resize(offset[nr_chunks]);
+		next_chunk.store(0);
+		pool.Run([&](int, int)
+			{
+				for (size_t t = next_chunk.fetch_add(1); t < nr_chunks; t = next_chunk.fetch_add(1))
+				{
+					std::copy(pieces[t].begin(), pieces[t].end(), lines.begin() + offset[t]);
+				}
+			});
+		equal_slope = total_equal_slope.load();
+		dominated = a.size() + b.size() - lines.size() - equal_slope;
+		clipped = Clip(lower, upper);
+	}
+
+	//Counters of the last merge: lines dropped for an equal slope, lines dominated by the envelope and lines clipped to the bounds
+	size_t equal_slope = 0;
+	size_t dominated = 0;
+	size_t clipped = 0;
+
+private:
+	std::vector<std::vector<Line>> pieces; //Pieces of Merge_chunked, kept to reuse their memory
+};
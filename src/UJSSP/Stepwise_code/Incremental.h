@@ -0,0 +1,138 @@
+#pragma once
+#include "Data.h"
+#include "Stepwise_engine.h"
+#include "Bounds.h"
+#include "Incumbent.h"
+#include<algorithm>
+#include<vector>
+
+//Forward stepwise method for a pool of jobs that changes between solves. Every interval steps the hull is saved as a
+//Forward_snapshot. The hull after the jobs 0..k-1 only depends on those jobs and on the bounds it was clipped with, so after
+//an edit the next solve continues from the last snapshot before the first changed position, if its bounds still hold:
+//	- ub_R of the snapshot is at least upper_R[k] of the new jobs, as Upper_R is nondecreasing in the bound of the jobs after it,
+//	so every earlier clip at upper_R[j + 1] was at a bound at least as large as the new one;
+//	- its target is at most a lower bound on the new optimum, so the lines clipped for not reaching it cannot reach the optimum either.
+//An edit that lowers the incumbent would make every snapshot fail the last test, so the hulls are clipped against a target slackened
+//by the largest gain p_j * r_j - c_j of a single job. Removing or changing job t costs the previous optimum at most the gain of t,
+//as dropping t from it changes the profit by P * (p_t * r_t - (1 - p_t) * R) - c_t, so the snapshots survive a single such edit.
+//Edits keep Data sorted; a job is referred to by its position in that order, as in the .out file.
+class Incremental_forward
+{
+public:
+	int resumed_step = 0; //Number of jobs the last solve did not have to step again
+	long long nr_sets = 0; //Sets considered by the last solve
+	std::vector<Step_stats> trace; //Counters of the steps of the last solve
+
+	//A snapshot every interval steps, pool (if any) steps large hulls
+	Incremental_forward(int interval, Thread_pool* pool = nullptr) : interval(std::max(interval, 1)), pool(pool)
+	{
+	}
+
+	//Optimal profit of the current jobs of Data, with its selection
+	double Solve(std::vector<bool>& selection)
+	{
+		int n = Data::n;
+		int changed = 0; //First position at which the jobs differ from the previous solve
+		while (changed < n && changed < (int)solved_r.size() && solved_r[changed] == Data::r[changed] && solved_c[changed] == Data::c[changed] && solved_p[changed] == Data::p[changed])
+		{
+			changed++;
+		}
+
+		upper_R = Stepwise_bounds::Upper_R();
+		std::vector<bool> incumbent_set;
+		double lower_bound = Stepwise_incumbent::Solve(incumbent_set);
+		if (!solved_r.empty())
+		{
+			lower_bound = std::max(lower_bound, solved_profit - lost_gain);
+		}
+		double target = Stepwise_bounds::Target(lower_bound);
+		while (!snapshots.empty() && (snapshots.back().step > changed || snapshots.back().ub_R < upper_R[snapshots.back().step] || snapshots.back().target > target))
+		{
+			snapshots.pop_back();
+		}
+		double slack = 0;
+		for (int j = 0; j < n; j++)
+		{
+			slack = std::max(slack, Gain(j));
+		}
+
+		//A snapshot stays valid for the target it was clipped with, which the steps after it must not exceed
+		Forward_engine engine(upper_R, snapshots.empty() ? target - slack : std::max(target - slack, snapshots.back().target), pool);
+		if (!snapshots.empty())
+		{
+			engine.Restore(snapshots.back());
+		}
+		resumed_step = engine.next_job;
+		for (int j = engine.next_job; j < n; j++)
+		{
+			if (j % interval == 0 && j > resumed_step)
+			{
+				snapshots.push_back(engine.Save());
+			}
+			engine.Step(j);
+		}
+
+		solved_r = Data::r;
+		solved_c = Data::c;
+		solved_p = Data::p;
+		solved_profit = engine.hull[0].intercept;
+		lost_gain = 0;
+		nr_sets = engine.nr_sets;
+		trace = std::move(engine.trace);
+		selection = engine.tree.Materialize(engine.hull[0].set, n);
+		return engine.hull[0].intercept;
+	}
+
+	void Add_job(int r, int c, double p)
+	{
+		Data::r.push_back(r);
+		Data::c.push_back(c);
+		Data::p.push_back(p);
+		Data::ratio.push_back(Ratio(r, p));
+		Data::n++;
+		Data::SortData();
+	}
+
+	void Remove_job(int position)
+	{
+		lost_gain += Gain(position);
+		Data::r.erase(Data::r.begin() + position);
+		Data::c.erase(Data::c.begin() + position);
+		Data::p.erase(Data::p.begin() + position);
+		Data::ratio.erase(Data::ratio.begin() + position);
+		Data::n--;
+	}
+
+	void Modify_job(int position, int r, int c, double p)
+	{
+		lost_gain += Gain(position);
+		Data::r[position] = r;
+		Data::c[position] = c;
+		Data::p[position] = p;
+		Data::ratio[position] = Ratio(r, p);
+		Data::SortData();
+	}
+
+private:
+	int interval;
+	Thread_pool* pool;
+	std::vector<double> upper_R;
+	std::vector<Forward_snapshot> snapshots; //Increasing in step
+	std::vector<int> solved_r; //Jobs of the previous solve
+	std::vector<int> solved_c;
+	std::vector<double> solved_p;
+	double solved_profit = 0; //Optimum of the previous solve
+	double lost_gain = 0; //Gains of the jobs removed or changed since, the optimum is at least solved_profit - lost_gain
+
+	//Largest amount by which job j can add to the profit of a selection
+	static double Gain(int j)
+	{
+		return std::max(0.0, Data::p[j] * Data::r[j] - Data::c[j]);
+	}
+
+	//Sort key of Data
+	static double Ratio(int r, double p)
+	{
+		return ((double)r * p) / (1 - p);
+	}
+};
@@ -0,0 +1,142 @@
+#pragma once
+#include "Data.h"
+#include<cmath>
+#include<vector>
+
+//Fast heuristic selection for the stepwise methods, used as an incumbent: its profit is a lower bound on the optimum.
+//Jobs are in ratio order, so the profit of a selection is sum over selected i of r_i * (product of the selected p_k, k <= i) minus its costs.
+namespace Stepwise_incumbent
+{
+	//Exact profit of selection
+	inline double Profit(const std::vector<bool>& selection)
+	{
+		double revenue = 0;
+		double cost = 0;
+		for (int i = Data::n - 1; i >= 0; i--)
+		{
+			if (selection[i])
+			{
+				revenue = Data::p[i] * (Data::r[i] + revenue);
+				cost += Data::c[i];
+			}
+		}
+		return revenue - cost;
+	}
+
+	//Greedy over the jobs begin..end-1 on their own, from last to first, adding a job whenever this improves the profit of the range.
+	//Sets the selected jobs in selection and returns the revenue of the range as seen from begin, its probability and its cost.
+	inline void Greedy(int begin, int end, std::vector<bool>& selection, double& revenue, double& probability, double& cost)
+	{
+		revenue = 0;
+		probability = 1.0;
+		cost = 0;
+		for (int i = end - 1; i >= begin; i--)
+		{
+			double including = Data::p[i] * (Data::r[i] + revenue);
+			if (including - Data::c[i] > revenue)
+			{
+				revenue = including;
+				probability *= Data::p[i];
+				cost += Data::c[i];
+				selection[i] = true;
+			}
+		}
+	}
+
+	//Greedy from last to first job, adding a job whenever this improves the profit, as in the dynamic programming.
+	//Then sweeps of local moves from last to first: at every position t the best of the four choices for the pair
+	//of jobs t and t + 1 is taken, which covers adding, dropping and swapping neighbours. A move is evaluated in O(1)
+	//from the probability of the selected jobs before t (prefix products of the previous sweep, not yet changed in this sweep)
+	//and the revenue of the selected jobs after t + 1 (kept up to date during the sweep), so it is exact.
+	//At most log2(n) + 1 sweeps of O(n) are done.
+	inline double Solve(std::vector<bool>& selection)
+	{
+		int n = Data::n;
+		selection.assign(n, false);
+		double revenue, probability, cost;
+		Greedy(0, n, selection, revenue, probability, cost);
+		if (n < 2)
+		{
+			return Profit(selection);
+		}
+
+		std::vector<double> before(n); //Probability of the selected jobs before i
+		int max_sweeps = (int)std::log2((double)n) + 1;
+		for (int sweep = 0; sweep < max_sweeps; sweep++)
+		{
+			double prob = 1.0;
+			for (int i = 0; i < n; i++)
+			{
+				before[i] = prob;
+				if (selection[i])
+				{
+					prob *= Data::p[i];
+				}
+			}
+
+			bool improved = false;
+			double after = 0; //Revenue of the selected jobs after t + 1, as seen from t + 2
+			for (int t = n - 2; t >= 0; t--)
+			{
+				double best_value = 0;
+				int best_choice = -1;
+				for (int choice = 0; choice < 4; choice++)
+				{
+					bool take_t = choice & 1;
+					bool take_next = choice & 2;
+					double value = after;
+					double cost = 0;
+					if (take_next)
+					{
+						value = Data::p[t + 1] * (Data::r[t + 1] + value);
+						cost += Data::c[t + 1];
+					}
+					if (take_t)
+					{
+						value = Data::p[t] * (Data::r[t] + value);
+						cost += Data::c[t];
+					}
+					value = before[t] * value - cost;
+					if (best_choice == -1 || value > best_value)
+					{
+						best_value = value;
+						best_choice = choice;
+					}
+				}
+
+				//Only leave the current choice for a strict improvement, so the sweeps cannot cycle
+				int current = (selection[t] ? 1 : 0) + (selection[t + 1] ? 2 : 0);
+				if (best_choice != current)
+				{
+					double current_value = after;
+					double current_cost = 0;
+					if (selection[t + 1])
+					{
+						current_value = Data::p[t + 1] * (Data::r[t + 1] + current_value);
+						current_cost += Data::c[t + 1];
+					}
+					if (selection[t])
+					{
+						current_value = Data::p[t] * (Data::r[t] + current_value);
+						current_cost += Data::c[t];
+					}
+					if (best_value > before[t] * current_value - current_cost + 1e-12 * (std::fabs(best_value) + 1.0))
+					{
+						selection[t] = best_choice & 1;
+						selection[t + 1] = best_choice & 2;
+						improved = true;
+					}
+				}
+				if (selection[t + 1])
+				{
+					after = Data::p[t + 1] * (Data::r[t + 1] + after);
+				}
+			}
+			if (!improved)
+			{
+				break;
+			}
+		}
+		return Profit(selection);
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include<cstddef>
+#include<vector>
+
+//Persistent tree of the subsets kept by the stepwise methods: a subset is a node holding the job that was added last
+//and the node of the subset it was added to, so adding a job costs one node instead of a copy of n bits.
+//Subsets are referred to by 4-byte handles, the empty set is handle -1. A parent is always created before its children.
+class Set_tree
+{
+public:
+	//Handle of the subset parent with job added
+	int Add(int parent, int job)
+	{
+		nodes.push_back({ parent, job });
+		return (int)nodes.size() - 1;
+	}
+
+	//Reserve count consecutive handles, whose nodes are filled in by Set (possibly from several threads)
+	int Reserve(int count)
+	{
+		int first = (int)nodes.size();
+		nodes.resize(nodes.size() + count);
+		return first;
+	}
+
+	void Set(int handle, int parent, int job)
+	{
+		nodes[handle] = { parent, job };
+	}
+
+	//Remove the nodes that are not part of the subsets of the given lines (with a member set holding the handle)
+	//and renumber their handles in place.
+	//Only runs when the tree has grown to twice its size after the previous collection, so it costs O(1) per added node.
+	template<typename Line>
+	void Collect(std::vector<Line>& lines)
+	{
+		if (nodes.size() < 2 * live_nodes + 1024)
+		{
+			return;
+		}
+		Compact(lines);
+	}
+
+	//Same as Collect, but always runs
+	template<typename Line>
+	void Compact(std::vector<Line>& lines)
+	{
+		std::vector<int> new_index(nodes.size(), -1);
+		for (const Line& line : lines)
+		{
+			for (int node = line.set; node != -1 && new_index[node] == -1; node = nodes[node].parent)
+			{
+				new_index[node] = 0;
+			}
+		}
+
+		//Parents come before their children, so a single forward pass keeps that order and can renumber the parents
+		size_t size = 0;
+		for (size_t node = 0; node < nodes.size(); node++)
+		{
+			if (new_index[node] == 0)
+			{
+				int parent = nodes[node].parent;
+				nodes[size] = { parent == -1 ? -1 : new_index[parent], nodes[node].job };
+				new_index[node] = (int)size;
+				size++;
+			}
+		}
+		nodes.resize(size);
+		live_nodes = size;
+		for (Line& line : lines)
+		{
+			if (line.set != -1)
+			{
+				line.set = new_index[line.set];
+			}
+		}
+	}
+
+	//Membership vector of subset handle over n jobs
+	std::vector<bool> Materialize(int handle, int n) const
+	{
+		std::vector<bool> set(n, false);
+		for (int node = handle; node != -1; node = nodes[node].parent)
+		{
+			set[nodes[node].job] = true;
+		}
+		return set;
+	}
+
+	size_t Size() const
+	{
+		return nodes.size();
+	}
+
+private:
+	struct Node
+	{
+		int parent;
+		int job;
+	};
+	std::vector<Node> nodes;
+	size_t live_nodes = 0; //Number of nodes after the last collection
+};
@@ -0,0 +1,54 @@
+#pragma once
+#include<fstream>
+#include<string>
+#include<vector>
+
+//Counters of one step of a stepwise engine. Every line of the hull before the step and every candidate ends up either in the
+//hull after the step or in exactly one of the pruning counters: hull_before + candidates = hull_after + equal_slope + dominated + clipped + approximated.
+struct Step_stats
+{
+	int job;
+	int hull_before;
+	int candidates; //New subsets generated
+	int filtered; //Lines of the hull not extended because of the SPEEDUPS filter or because the job is never worthwhile
+	int equal_slope; //Lines dropped for another line with the same slope and a higher intercept
+	int dominated; //Lines not on the upper envelope
+	int clipped; //Lines only optimal outside the bounds on x, including the incumbent bound
+	int approximated; //Lines removed by the approximate mode
+	int old_erased; //Lines of the hull before the step that are no longer in it
+	int hull_after;
+	double seconds;
+};
+
+//Write the steps of the engines named in names (one letter each) as CSV with one line per step
+inline bool Write_trace(const std::string& filename, const std::vector<const std::vector<Step_stats>*>& traces, const std::string& names)
+{
+	std::ofstream out(filename);
+	if (!out)
+	{
+		return false;
+	}
+	out << "engine,step,job,hull_before,candidates,filtered,equal_slope,dominated,clipped,approximated,old_erased,hull_after,seconds\n";
+	for (size_t e = 0; e < traces.size(); e++)
+	{
+		const std::vector<Step_stats>& trace = *traces[e];
+		for (size_t step = 0; step < trace.size(); step++)
+		{
+			const Step_stats& stats = trace[step];
+			out << names[e] << "," << step << "," << stats.job << "," << stats.hull_before << "," << stats.candidates << "," << stats.filtered << ","
+				<< stats.equal_slope << "," << stats.dominated << "," << stats.clipped << "," << stats.approximated << "," << stats.old_erased << "," << stats.hull_after << "," << stats.seconds << "\n";
+		}
+	}
+	return out.good();
+}
+
+//Trace file next to the output file: name.out becomes name.trace.csv
+inline std::string Trace_filename(const std::string& output_filename)
+{
+	std::string base = output_filename;
+	if (base.size() >= 4 && base.substr(base.size() - 4) == ".out")
+	{
+		base = base.substr(0, base.size() - 4);
+	}
+	return base + ".trace.csv";
+}
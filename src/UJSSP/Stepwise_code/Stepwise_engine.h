@@ -0,0 +1,332 @@
+#pragma once
+#include "Data.h"
+#include "Set_tree.h"
+#include "Hull.h"
+#include "Bounds.h"
+#include "Incumbent.h"
+#include "Extend_kernel.h"
+#include "Step_trace.h"
+#include<algorithm>
+#include<chrono>
+#include<limits>
+#include<vector>
+
+#ifndef SPEEDUPS
+#define SPEEDUPS true
+#endif
+
+//Hulls of at least PARALLEL_HULL_LINES lines are stepped on the thread pool of the engine: the new subsets are generated
+//in slices and the hulls are merged in pieces of CHUNK_LINES lines (see Hull::Merge_chunked). Smaller hulls are stepped serially.
+#ifndef PARALLEL_HULL_LINES
+#define PARALLEL_HULL_LINES 8192
+#endif
+#ifndef CHUNK_LINES
+#define CHUNK_LINES 1024
+#endif
+
+//Add job j to the subsets of the lines hull[begin..end) with kernel (Extend_kernel::Forward or Backward), writing the new lines
+//to new_sets and returning the handle of the first new subset. On the threads of pool if parallel, and then the limits of the new lines are set as well, as Hull::Merge_chunked needs:
+//the new lines are an upper envelope themselves, as adding a job maps every line to the same x-transformation of itself plus a common term.
+inline int Generate(Thread_pool* pool, bool parallel, Set_tree& tree, const Hull& hull, int begin, int end, int j, std::vector<Line>& new_sets,
+	void (*kernel)(const Line*, size_t, int, int, Line*, Set_tree&))
+{
+	int count = end - begin;
+	int base = tree.Reserve(count);
+	new_sets.resize(count);
+	if (!parallel)
+	{
+		kernel(hull.lines.data() + begin, count, j, base, new_sets.data(), tree);
+		return base;
+	}
+	auto slice = [count](int thread, int nr_threads) { return (int)((long long)count * thread / nr_threads); };
+	pool->Run([&](int thread, int nr_threads)
+		{
+			int from = slice(thread, nr_threads);
+			kernel(hull.lines.data() + begin + from, slice(thread + 1, nr_threads) - from, j, base + from, new_sets.data() + from, tree);
+		});
+	pool->Run([&](int thread, int nr_threads)
+		{
+			for (int i = slice(thread, nr_threads); i < slice(thread + 1, nr_threads); i++)
+			{
+				new_sets[i].limit = i + 1 < count ? Hull::Intersection(new_sets[i], new_sets[i + 1]) : std::numeric_limits<double>::max();
+			}
+		});
+	return base;
+}
+
+//Counters of a step of an engine from the hull before and after it (with the counters of its last merge) and the new subsets,
+//of which the handles start at base. Must be called before the tree collects, as that renumbers the handles, so the time of the step is set after.
+inline Step_stats Record_step(int j, size_t hull_before, int filtered, const std::vector<Line>& new_sets, const Hull& hull, size_t clipped, size_t approximated, int base)
+{
+	size_t new_kept = 0;
+	for (const Line& line : hull.lines)
+	{
+		new_kept += line.set >= base;
+	}
+	Step_stats stats;
+	stats.job = j;
+	stats.hull_before = (int)hull_before;
+	stats.candidates = (int)new_sets.size();
+	stats.filtered = filtered;
+	stats.equal_slope = (int)hull.equal_slope;
+	stats.dominated = (int)hull.dominated;
+	stats.clipped = (int)(hull.clipped + clipped);
+	stats.approximated = (int)approximated;
+	stats.old_erased = (int)(hull_before - (hull.size() - new_kept));
+	stats.hull_after = (int)hull.size();
+	stats.seconds = 0;
+	return stats;
+}
+
+//Approximate mode: remove the lines of hull that raise it by at most the share of the loss budget that is left for each of
+//the steps_left steps to go (this one included), so unused budget carries over. Adds the amount the hull was lowered by to
+//lowered and returns the number of lines removed. The optimal selection loses at most the sum of these amounts: at every step
+//the hull at its x (R or P) is lowered by at most that amount, or the hull no longer reaches the incumbent there.
+inline size_t Approximate(Hull& hull, double budget, double& lowered, int steps_left)
+{
+	if (budget <= lowered)
+	{
+		return 0;
+	}
+	size_t size = hull.size();
+	lowered += hull.Prune((budget - lowered) / steps_left);
+	return size - hull.size();
+}
+
+//Hull of a Forward_engine after the jobs 0..step-1, with a tree that only holds the subsets of the hull,
+//and the bounds it was clipped with (see Incremental_forward for when it can be continued with other jobs after step)
+struct Forward_snapshot
+{
+	int step;
+	std::vector<Line> lines;
+	Set_tree tree;
+	double ub_R;
+	double lb_R;
+	double target;
+};
+
+//Forward stepwise method: after the jobs 0..j the hull holds the subsets S of those jobs that are optimal for some revenue R
+//of the selected jobs after j, as the line (R(S) - C(S)) + P(S) * R. Jobs can be added one by one in increasing order.
+class Forward_engine
+{
+public:
+	Set_tree tree; //Nodes of all subsets, the hull only keeps their handles
+	Hull hull;
+	std::vector<Line> new_sets; //Subsets created by the last step
+	long long nr_sets = 1;
+	double ub_R;
+	double lb_R = 0;
+	int next_job = 0; //Jobs 0..next_job-1 have been added
+	double loss_budget = 0; //Approximate mode: amount by which the hull may be lowered in total, 0 for the exact method
+	double lowered = 0; //Amount by which the approximate mode has lowered the hull so far
+	std::vector<Step_stats> trace; //Counters of every step
+
+	//upper_R as in Stepwise_bounds::Upper_R, target the incumbent profit lowered by the margin, pool (if any) steps large hulls
+	Forward_engine(const std::vector<double>& upper_R, double target, Thread_pool* pool = nullptr) : upper_R(upper_R), target(target), pool(pool)
+	{
+		ub_R = upper_R[0];
+		hull.lines.push_back({ 0.0, 1.0, std::numeric_limits<double>::max(), -1 }); //Empty set
+	}
+
+	void Step(int j)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		size_t hull_before = hull.size();
+
+		//Add extra subsets, the lines of the hull mapped to job j keep their order of slopes
+		int first = 0;
+#if SPEEDUPS
+		//Never optimal to add this job to the subsets that are only optimal up to R < p_j * r_j, as revenue will be too high
+		first = (int)hull.First_limit_from(Data::p[j] * Data::r[j], false);
+		if (!Stepwise_bounds::Worthwhile(j))
+		{
+			first = (int)hull.size();
+		}
+#endif
+		bool parallel = pool != nullptr && hull.size() >= PARALLEL_HULL_LINES;
+		int base = Generate(pool, parallel, tree, hull, first, (int)hull.size(), j, new_sets, Extend_kernel::Forward);
+		nr_sets += hull.size() + new_sets.size();
+
+		//Update upperbound
+		ub_R = upper_R[j + 1];
+
+		//Merge the hull with the new subsets, keeping only subsets that are optimal for some lb_R <= R <= ub_R
+		//The costs of the jobs after j are nonnegative, so the optimal selection has an R at which the hull reaches the incumbent
+		if (parallel)
+		{
+			merged.Merge_chunked(hull.lines, new_sets, 0.0, ub_R, *pool, CHUNK_LINES);
+		}
+		else
+		{
+			merged.Merge(hull.lines, new_sets, 0.0, ub_R);
+		}
+		lb_R = std::max(0.0, merged.First_reaching(target));
+		size_t clipped = merged.Clip(lb_R, ub_R);
+		size_t approximated = Approximate(merged, loss_budget, lowered, Data::n - j);
+		std::swap(hull, merged);
+		trace.push_back(Record_step(j, hull_before, first, new_sets, hull, clipped, approximated, base));
+		next_job = j + 1;
+
+		//Free the nodes of subsets that left the hull
+		tree.Collect(hull.lines);
+		trace.back().seconds = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	//Snapshot of the engine between steps. Collects the tree first, so that the snapshot only copies the subsets of the hull.
+	Forward_snapshot Save()
+	{
+		tree.Compact(hull.lines);
+		return { next_job, hull.lines, tree, ub_R, lb_R, target };
+	}
+
+	//Continue after the jobs 0..snapshot.step-1 of snapshot, which must not have changed
+	void Restore(const Forward_snapshot& snapshot)
+	{
+		next_job = snapshot.step;
+		hull.lines = snapshot.lines;
+		tree = snapshot.tree;
+		ub_R = snapshot.ub_R;
+		lb_R = snapshot.lb_R;
+	}
+
+	//Best complete selection that can be read from the hull between steps: the subset of the first line without further jobs (R = 0),
+	//or the greedy selection of the remaining jobs after the subset of the line optimal at the revenue of that greedy selection
+	std::vector<bool> Best_selection() const
+	{
+		std::vector<bool> selection(Data::n, false);
+		double revenue, probability, cost;
+		Stepwise_incumbent::Greedy(next_job, Data::n, selection, revenue, probability, cost);
+		const Line& line = hull[std::min(hull.First_limit_from(revenue, false), hull.size() - 1)];
+		if (line.intercept + line.slope * revenue - cost <= hull[0].intercept)
+		{
+			return tree.Materialize(hull[0].set, Data::n);
+		}
+		std::vector<bool> subset = tree.Materialize(line.set, Data::n);
+		for (int i = 0; i < next_job; i++)
+		{
+			selection[i] = subset[i];
+		}
+		return selection;
+	}
+
+	//Upper bound on the optimal profit between steps. Lines left out of the hull never beat the incumbent, the hull is nondecreasing
+	//and the jobs not yet added have a revenue of at most ub_R and nonnegative costs, so the hull at ub_R bounds the rest.
+	//The approximate mode may have lowered the hull by lowered.
+	double Upper_bound(double incumbent) const
+	{
+		const Line& line = hull.lines.back();
+		return std::max(incumbent, line.intercept + line.slope * ub_R) + lowered;
+	}
+
+private:
+	const std::vector<double>& upper_R;
+	double target;
+	Thread_pool* pool;
+	Hull merged;
+};
+
+//Backward stepwise method: after the jobs n-1..j the hull holds the subsets T of those jobs that are optimal for some probability P
+//of the selected jobs before j, as the line -C(T) + R(T) * P. Jobs can be added one by one in decreasing order.
+class Backward_engine
+{
+public:
+	Set_tree tree; //Nodes of all subsets, the hull only keeps their handles
+	Hull hull;
+	std::vector<Line> new_sets; //Subsets created by the last step
+	long long nr_sets = 1;
+	double ub_P = 1.0;
+	double lb_P;
+	int next_job = Data::n; //Jobs next_job..n-1 have been added
+	double loss_budget = 0; //Approximate mode: amount by which the hull may be lowered in total, 0 for the exact method
+	double lowered = 0; //Amount by which the approximate mode has lowered the hull so far
+	std::vector<Step_stats> trace; //Counters of every step
+
+	//lower_P and gain as in Stepwise_bounds::Lower_P and Prefix_gain, target the incumbent profit lowered by the margin,
+	//pool (if any) steps large hulls
+	Backward_engine(const std::vector<double>& lower_P, const std::vector<double>& gain, double target, Thread_pool* pool = nullptr) : lower_P(lower_P), gain(gain), target(target), pool(pool)
+	{
+		lb_P = lower_P[Data::n];
+		hull.lines.push_back({ 0.0, 0.0, std::numeric_limits<double>::max(), -1 }); //Empty set
+	}
+
+	void Step(int j)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		size_t hull_before = hull.size();
+
+		//Add extra subsets, the lines of the hull mapped to job j keep their order of slopes
+		int last = (int)hull.size();
+#if SPEEDUPS
+		//Never optimal to add this job to the subsets that are only optimal from P > p_j on, as probability would be too low
+		last = std::min((int)hull.First_limit_from(Data::p[j], true) + 1, (int)hull.size());
+		if (!Stepwise_bounds::Worthwhile(j))
+		{
+			last = 0;
+		}
+#endif
+		bool parallel = pool != nullptr && hull.size() >= PARALLEL_HULL_LINES;
+		int base = Generate(pool, parallel, tree, hull, 0, last, j, new_sets, Extend_kernel::Backward);
+		nr_sets += hull.size() + new_sets.size();
+
+		//Update lowerbound
+		lb_P = lower_P[j];
+
+		//Merge the hull with the new subsets, keeping only subsets that are optimal for some lb_P <= P <= ub_P
+		//The hull plus the profit of the selected jobs before j must reach the incumbent at the P of the optimal selection
+		if (parallel)
+		{
+			merged.Merge_chunked(hull.lines, new_sets, lb_P, ub_P, *pool, CHUNK_LINES);
+		}
+		else
+		{
+			merged.Merge(hull.lines, new_sets, lb_P, ub_P);
+		}
+		lb_P = std::max(lb_P, merged.First_reaching(target - gain[j]));
+		size_t clipped = merged.Clip(lb_P, ub_P);
+		size_t approximated = Approximate(merged, loss_budget, lowered, j + 1);
+		std::swap(hull, merged);
+		trace.push_back(Record_step(j, hull_before, (int)hull_before - last, new_sets, hull, clipped, approximated, base));
+		next_job = j;
+
+		//Free the nodes of subsets that left the hull
+		tree.Collect(hull.lines);
+		trace.back().seconds = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	//Best complete selection that can be read from the hull between steps: the subset of the last line without jobs before it (P = 1),
+	//or the greedy selection of the remaining jobs before the subset of the line optimal at the probability of that greedy selection
+	std::vector<bool> Best_selection() const
+	{
+		std::vector<bool> selection(Data::n, false);
+		double revenue, probability, cost;
+		Stepwise_incumbent::Greedy(0, next_job, selection, revenue, probability, cost);
+		const Line& line = hull[std::min(hull.First_limit_from(probability, false), hull.size() - 1)];
+		const Line& last = hull.lines.back();
+		if (revenue - cost + line.intercept + line.slope * probability <= last.intercept + last.slope)
+		{
+			return tree.Materialize(last.set, Data::n);
+		}
+		std::vector<bool> subset = tree.Materialize(line.set, Data::n);
+		for (int i = next_job; i < Data::n; i++)
+		{
+			selection[i] = subset[i];
+		}
+		return selection;
+	}
+
+	//Upper bound on the optimal profit between steps. Lines left out of the hull never beat the incumbent, the hull is nondecreasing
+	//and gain bounds the profit of the jobs not yet added, so gain plus the hull at ub_P bounds the rest.
+	//The approximate mode may have lowered the hull by lowered.
+	double Upper_bound(double incumbent) const
+	{
+		const Line& line = hull.lines.back();
+		return std::max(incumbent, gain[next_job] + line.intercept + line.slope * ub_P) + lowered;
+	}
+
+private:
+	const std::vector<double>& lower_P;
+	const std::vector<double>& gain;
+	double target;
+	Thread_pool* pool;
+	Hull merged;
+};